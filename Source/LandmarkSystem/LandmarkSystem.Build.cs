@@ -36,5 +36,10 @@ public class LandmarkSystem : ModuleRules
 				
 			}
 		);
+
+		if (Target.bBuildEditor)
+		{
+			PrivateDependencyModuleNames.Add("DirectoryWatcher");
+		}
 	}
 }
@@ -0,0 +1,487 @@
+#include "LandmarkSubsystem.h"
+#include "LandmarkSettings.h"
+#include "LandmarkViewCulling.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "GameFramework/PlayerController.h"
+#include "LandmarkSpatialIndex.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "LandmarkFileFormat.h"
+#include "LandmarkStore.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "JsonObjectConverter.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/App.h"
+
+#if !UE_BUILD_SHIPPING
+
+/**
+ * 开发用基准测试（控制台命令）。结果只写日志，不影响运行时状态。
+ * 所有合成数据使用固定种子，多次运行可直接对比。
+ */
+namespace LandmarkBenchmarks
+{
+	static const int32 DefaultCounts[] = { 10000, 100000, 1000000 };
+
+	static void ParseCounts(const TArray<FString>& Args, TArray<int32>& OutCounts)
+	{
+		for (const FString& Arg : Args)
+		{
+			const int32 Value = FCString::Atoi(*Arg);
+			if (Value > 0) OutCounts.Add(Value);
+		}
+		if (OutCounts.Num() == 0)
+		{
+			OutCounts.Append(DefaultCounts, UE_ARRAY_COUNT(DefaultCounts));
+		}
+	}
+
+	/**
+	 * Landmark.Bench.Projection [Count...]
+	 * 在玩家相机周围生成合成点，比较逐点 ProjectWorldLocationToScreen 与一次构建矩阵 + 批量投影。
+	 */
+	static void RunProjection(const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PC = World ? UGameplayStatics::GetPlayerController(World, 0) : nullptr;
+		if (!PC)
+		{
+			UE_LOG(LogLandmarkSystem, Warning, TEXT("Landmark.Bench.Projection: no player controller"));
+			return;
+		}
+
+		FVector CamLoc;
+		FRotator CamRot;
+		PC->GetPlayerViewPoint(CamLoc, CamRot);
+		const float Radius = FMath::Max(20000.0f, CamLoc.Z * 4.0f);
+		const float PlaneZ = 147.0f;
+
+		TArray<int32> Counts;
+		ParseCounts(Args, Counts);
+
+		for (const int32 Count : Counts)
+		{
+			FRandomStream Rand(0x4C4D);
+			TArray<FVector> Points;
+			Points.SetNumUninitialized(Count);
+			for (FVector& P : Points)
+			{
+				P = FVector(CamLoc.X + Rand.FRandRange(-Radius, Radius), CamLoc.Y + Rand.FRandRange(-Radius, Radius), PlaneZ);
+			}
+
+			// A: 逐点引擎路径（每个点都重新取投影数据、构建矩阵）
+			int32 VisibleA = 0;
+			const double StartA = FPlatformTime::Seconds();
+			for (const FVector& P : Points)
+			{
+				FVector2D Screen;
+				if (PC->ProjectWorldLocationToScreen(P, Screen, true))
+				{
+					++VisibleA;
+				}
+			}
+			const double TimeA = FPlatformTime::Seconds() - StartA;
+
+			// B: 矩阵构建一次 + SoA 收集 + 4 路向量化投影
+			TArray<float> RelX, RelY, OutX, OutY;
+			TArray<uint8> Flags;
+			RelX.SetNumUninitialized(Count);
+			RelY.SetNumUninitialized(Count);
+			OutX.SetNumUninitialized(Count);
+			OutY.SetNumUninitialized(Count);
+			Flags.SetNumUninitialized(Count);
+
+			int32 VisibleB = 0;
+			const double StartB = FPlatformTime::Seconds();
+			FLandmarkViewProjection Projection;
+			if (Projection.BuildFromPlayer(PC))
+			{
+				for (int32 i = 0; i < Count; ++i)
+				{
+					RelX[i] = (float)(Points[i].X - Projection.ViewOrigin.X);
+					RelY[i] = (float)(Points[i].Y - Projection.ViewOrigin.Y);
+				}
+				Projection.ProjectBatch(RelX.GetData(), RelY.GetData(), (float)(PlaneZ - Projection.ViewOrigin.Z), Count, 0.0f,
+					OutX.GetData(), OutY.GetData(), Flags.GetData());
+				for (const uint8 Flag : Flags)
+				{
+					VisibleB += (Flag == ELandmarkProjection::Visible) ? 1 : 0;
+				}
+			}
+			const double TimeB = FPlatformTime::Seconds() - StartB;
+
+			UE_LOG(LogLandmarkSystem, Log, TEXT("Landmark.Bench.Projection N=%d | per-point %.3f ms (%d visible) | batch %.3f ms (%d visible) | speedup %.1fx"),
+				Count, TimeA * 1000.0, VisibleA, TimeB * 1000.0, VisibleB, TimeB > 0.0 ? TimeA / TimeB : 0.0);
+		}
+	}
+
+	/**
+	 * Landmark.Bench.CullScaling [Count]
+	 * 在当前视锥足迹内生成合成地图（默认 200k 地标），把剔除（格子高度过滤 + 投影 + 曲线表）
+	 * 分成 1..N 路在工作线程上执行，报告每种路数的耗时与加速比。每路处理连续的行/候选区间。
+	 */
+	static void RunCullScaling(const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerController* PC = World ? UGameplayStatics::GetPlayerController(World, 0) : nullptr;
+		FLandmarkViewProjection Projection;
+		if (!PC || !Projection.BuildFromPlayer(PC))
+		{
+			UE_LOG(LogLandmarkSystem, Warning, TEXT("Landmark.Bench.CullScaling: no player view"));
+			return;
+		}
+
+		FVector CamLoc;
+		FRotator CamRot;
+		PC->GetPlayerViewPoint(CamLoc, CamRot);
+		int32 ViewX = 0, ViewY = 0;
+		PC->GetViewportSize(ViewX, ViewY);
+		const float PlaneZ = 147.0f;
+
+		FLandmarkGroundFootprint Footprint;
+		if (!Footprint.Build(CamLoc, CamRot, 90.0f, ViewY > 0 ? (float)ViewX / (float)ViewY : 16.0f / 9.0f, PlaneZ, FMath::Max(20000.0f, CamLoc.Z * 4.0f)))
+		{
+			UE_LOG(LogLandmarkSystem, Warning, TEXT("Landmark.Bench.CullScaling: camera does not see the label plane"));
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 && FCString::Atoi(*Args[0]) > 0 ? FCString::Atoi(*Args[0]) : 200000;
+
+		// 合成地图：足迹包围盒内均匀分布，可见高度区间随机
+		FRandomStream Rand(0x4C4D);
+		TArray<double> PosX, PosY;
+		PosX.SetNumUninitialized(Count);
+		PosY.SetNumUninitialized(Count);
+		FLandmarkSpatialIndex Index;
+		Index.Configure(4096.0f, 10000.0f);
+		for (int32 i = 0; i < Count; ++i)
+		{
+			PosX[i] = Rand.FRandRange(Footprint.Bounds.Min.X, Footprint.Bounds.Max.X);
+			PosY[i] = Rand.FRandRange(Footprint.Bounds.Min.Y, Footprint.Bounds.Max.Y);
+			const float ZMin = Rand.FRandRange(0.0f, CamLoc.Z);
+			Index.Add(i, PosX[i], PosY[i], ZMin, ZMin + Rand.FRandRange(0.0f, CamLoc.Z * 2.0f));
+		}
+
+		const int32 Level = Index.SelectLevel(CamLoc.Z);
+		TArray<FLandmarkCellSpan> Spans;
+		Footprint.GetCellSpans(Index.GetCellSize(Level), Spans);
+
+		FLandmarkCurveTable ScaleTable, AlphaTable;
+		ScaleTable.Update(nullptr, 1.0f);
+		AlphaTable.Update(nullptr, 1.0f);
+
+		const int32 MaxWays = FMath::Max(1, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+		const int32 Iterations = 10;
+		double BaseTime = 0.0;
+
+		for (int32 Ways = 1; Ways <= MaxWays; Ways *= 2)
+		{
+			struct FWay
+			{
+				TArray<int32> Slots;
+				TArray<float> RelX, RelY;
+				FLandmarkCullChunk Chunk;
+			};
+			TArray<FWay> WayData;
+			WayData.SetNum(Ways);
+			int32 NumVisible = 0;
+
+			const double Start = FPlatformTime::Seconds();
+			for (int32 Iter = 0; Iter < Iterations; ++Iter)
+			{
+				ParallelFor(Ways, [&](int32 Way)
+				{
+					FWay& W = WayData[Way];
+					W.Slots.Reset();
+					W.RelX.Reset();
+					W.RelY.Reset();
+
+					const int32 RowBegin = Spans.Num() * Way / Ways;
+					const int32 RowEnd = Spans.Num() * (Way + 1) / Ways;
+					TArray<int32> Eligible;
+					for (int32 Row = RowBegin; Row < RowEnd; ++Row)
+					{
+						for (int32 CellX = Spans[Row].MinX; CellX <= Spans[Row].MaxX; ++CellX)
+						{
+							const FLandmarkSpatialCell* Cell = Index.FindCell(Level, FIntPoint(CellX, Spans[Row].Y));
+							if (!Cell) continue;
+							Eligible.Reset();
+							Cell->GetVisibleAt(CamLoc.Z, Eligible);
+							for (const int32 Slot : Eligible)
+							{
+								W.Slots.Add(Slot);
+								W.RelX.Add((float)(PosX[Slot] - Projection.ViewOrigin.X));
+								W.RelY.Add((float)(PosY[Slot] - Projection.ViewOrigin.Y));
+							}
+						}
+					}
+
+					FLandmarkCullInput In;
+					In.Projection = &Projection;
+					In.ScaleTable = &ScaleTable;
+					In.AlphaTable = &AlphaTable;
+					In.Slots = W.Slots.GetData();
+					In.RelX = W.RelX.GetData();
+					In.RelY = W.RelY.GetData();
+					In.RelZ = (float)(PlaneZ - Projection.ViewOrigin.Z);
+					CullCandidateRange(In, 0, W.Slots.Num(), W.Chunk);
+				});
+
+				NumVisible = 0;
+				for (const FWay& W : WayData)
+				{
+					NumVisible += W.Chunk.Num();
+				}
+			}
+			const double Time = (FPlatformTime::Seconds() - Start) / Iterations;
+			if (Ways == 1)
+			{
+				BaseTime = Time;
+			}
+
+			UE_LOG(LogLandmarkSystem, Log, TEXT("Landmark.Bench.CullScaling N=%d ways=%d | %.3f ms | %d visible | speedup %.2fx"),
+				Count, Ways, Time * 1000.0, NumVisible, Time > 0.0 ? BaseTime / Time : 0.0);
+
+			if (Ways < MaxWays && Ways * 2 > MaxWays)
+			{
+				Ways = MaxWays / 2; // 最后一轮跑满全部核心
+			}
+		}
+	}
+
+	/** Synthetic landmarks and the equivalent JSON text (file axes, see LandmarkFileFormat::ParseJson). */
+	static void MakeSyntheticLandmarks(int32 Count, TArray<FLandmarkInstanceData>& OutRecords, FString& OutJson)
+	{
+		FRandomStream Rand(0x4C4D);
+		OutRecords.SetNum(Count);
+		OutJson.Reset(Count * 160);
+		OutJson += TEXT("[");
+		for (int32 i = 0; i < Count; ++i)
+		{
+			FLandmarkInstanceData& Data = OutRecords[i];
+			Data.ID = FString::Printf(TEXT("BENCH_%d"), i);
+			Data.Name = FString::Printf(TEXT("Landmark %d"), i);
+			Data.Type = FString::Printf(TEXT("City%d"), 1 + (i % 5));
+			Data.X = Rand.FRandRange(-2000000.0f, 2000000.0f);
+			Data.Y = Rand.FRandRange(-2000000.0f, 2000000.0f);
+			Data.ZMin = 0.0;
+			Data.ZMax = Rand.FRandRange(20000.0f, 400000.0f);
+			Data.Value = 1 + (i % 11);
+			Data.Team = i % 4;
+
+			OutJson += FString::Printf(TEXT("%s{\"ID\":\"%s\",\"Name\":\"%s\",\"Type\":\"%s\",\"X\":%.2f,\"Y\":%.2f,\"ZMin\":%.1f,\"ZMax\":%.1f,\"Value\":%d,\"Team\":%d}"),
+				i > 0 ? TEXT(",") : TEXT(""), *Data.ID, *Data.Name, *Data.Type, Data.Y, Data.X, Data.ZMin, Data.ZMax, Data.Value, Data.Team);
+		}
+		OutJson += TEXT("]");
+	}
+
+	/**
+	 * Landmark.Bench.JsonParse [Count]
+	 * 同一份文件：整份读入 + DOM + 逐条反射（旧加载方式） vs. 流式 token 解析。
+	 * 内存为解析结束时（结果仍持有）相对开始时的进程物理内存增量，只作量级参考。
+	 */
+	static void RunJsonParse(const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 Count = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 700000; // 约 100MB
+
+		const FString Dir = FPaths::ProjectSavedDir() / TEXT("LandmarkBench");
+		IFileManager::Get().MakeDirectory(*Dir, true);
+		const FString JsonPath = Dir / FString::Printf(TEXT("Landmarks_Parse_%d.json"), Count);
+		{
+			TArray<FLandmarkInstanceData> Records;
+			FString Json;
+			MakeSyntheticLandmarks(Count, Records, Json);
+			FFileHelper::SaveStringToFile(Json, *JsonPath);
+		}
+
+		double DomTime = 0.0;
+		int64 DomBytes = 0;
+		int32 DomRecords = 0;
+		{
+			const uint64 BaseMemory = FPlatformMemory::GetStats().UsedPhysical;
+			const double Start = FPlatformTime::Seconds();
+			FString Text;
+			FFileHelper::LoadFileToString(Text, *JsonPath);
+			TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Text);
+			TArray<TSharedPtr<FJsonValue>> JsonArray;
+			TArray<FLandmarkInstanceData> Records;
+			if (FJsonSerializer::Deserialize(Reader, JsonArray))
+			{
+				Records.Reserve(JsonArray.Num());
+				for (const TSharedPtr<FJsonValue>& Value : JsonArray)
+				{
+					const TSharedPtr<FJsonObject>* ObjectPtr;
+					if (Value->TryGetObject(ObjectPtr) && ObjectPtr)
+					{
+						FLandmarkInstanceData& Data = Records.AddDefaulted_GetRef();
+						FJsonObjectConverter::JsonObjectToUStruct((*ObjectPtr).ToSharedRef(), &Data);
+						Data.X = (double)(*ObjectPtr)->GetNumberField(TEXT("Y"));
+						Data.Y = (double)(*ObjectPtr)->GetNumberField(TEXT("X"));
+					}
+				}
+			}
+			DomTime = FPlatformTime::Seconds() - Start;
+			DomBytes = (int64)FPlatformMemory::GetStats().UsedPhysical - (int64)BaseMemory;
+			DomRecords = Records.Num();
+		}
+
+		double StreamTime = 0.0;
+		int64 StreamBytes = 0;
+		int32 StreamRecords = 0;
+		{
+			const uint64 BaseMemory = FPlatformMemory::GetStats().UsedPhysical;
+			const double Start = FPlatformTime::Seconds();
+			TArray<FLandmarkInstanceData> Records;
+			LandmarkFileFormat::ReadJsonFile(JsonPath, Records);
+			StreamTime = FPlatformTime::Seconds() - Start;
+			StreamBytes = (int64)FPlatformMemory::GetStats().UsedPhysical - (int64)BaseMemory;
+			StreamRecords = Records.Num();
+		}
+
+		UE_LOG(LogLandmarkSystem, Log, TEXT("Landmark.Bench.JsonParse N=%d (%.1f MB) | dom %.1f ms, +%.1f MB, %d records | stream %.1f ms, +%.1f MB, %d records | speedup %.1fx"),
+			Count, IFileManager::Get().FileSize(*JsonPath) / (1024.0 * 1024.0),
+			DomTime * 1000.0, DomBytes / (1024.0 * 1024.0), DomRecords,
+			StreamTime * 1000.0, StreamBytes / (1024.0 * 1024.0), StreamRecords,
+			StreamTime > 0.0 ? DomTime / StreamTime : 0.0);
+
+		IFileManager::Get().Delete(*JsonPath);
+	}
+
+	/**
+	 * Landmark.Bench.Load [Count...]
+	 * 生成同一份合成数据的 JSON 与 .lmkb，比较"解析 + 写入存储 + 建空间索引"的总耗时。
+	 * 文件写在 Saved/LandmarkBench 下，测完删除；两种格式都是刚写出的文件，同样处于系统缓存中。
+	 */
+	static void RunLoad(const TArray<FString>& Args, UWorld* World)
+	{
+		const FString Dir = FPaths::ProjectSavedDir() / TEXT("LandmarkBench");
+		IFileManager::Get().MakeDirectory(*Dir, true);
+
+		float CellSize = 4096.0f;
+		float Altitude = 10000.0f;
+		if (const ULandmarkSettings* Settings = ULandmarkSettings::Get())
+		{
+			CellSize = Settings->SpatialBaseCellSize;
+			Altitude = Settings->SpatialBaseAltitude;
+		}
+
+		TArray<int32> Counts;
+		ParseCounts(Args, Counts);
+
+		for (const int32 Count : Counts)
+		{
+			TArray<FLandmarkInstanceData> Records;
+			FString Json;
+			MakeSyntheticLandmarks(Count, Records, Json);
+
+			const FString JsonPath = Dir / FString::Printf(TEXT("Landmarks_Bench_%d.json"), Count);
+			const FString BinaryPath = FPaths::ChangeExtension(JsonPath, LandmarkFileFormat::BinaryExtension);
+			FFileHelper::SaveStringToFile(Json, *JsonPath);
+			LandmarkFileFormat::WriteBinary(BinaryPath, Records, CellSize, Altitude);
+			Json.Empty();
+			Records.Empty();
+
+			// JSON：流式解析 -> 逐条注册（键在加载时哈希）-> 逐点建索引
+			double JsonTime = 0.0;
+			{
+				const double Start = FPlatformTime::Seconds();
+				TArray<FLandmarkInstanceData> Parsed;
+				LandmarkFileFormat::ReadJsonFile(JsonPath, Parsed);
+
+				FLandmarkStore Store;
+				TUniquePtr<FLandmarkSpatialIndex> Index = MakeUnique<FLandmarkSpatialIndex>();
+				Index->Configure(CellSize, Altitude);
+				for (const FLandmarkInstanceData& Data : Parsed)
+				{
+					const FLandmarkHandle Handle = Store.Add(FLandmarkId::FromString(Data.ID), Data);
+					Index->Add(Handle.Index, Data.X, Data.Y, (float)Data.ZMin, (float)Data.ZMax);
+				}
+				JsonTime = FPlatformTime::Seconds() - Start;
+			}
+
+			// 二进制：映射 -> 直接读 SoA 数组写入存储 -> 填入预构建的格子
+			double BinaryTime = 0.0;
+			{
+				const double Start = FPlatformTime::Seconds();
+				FLandmarkBinaryFile File;
+				if (File.Open(BinaryPath))
+				{
+					FLandmarkStore Store;
+					Store.Reserve(File.Num());
+					TArray<int32> SlotOf;
+					SlotOf.SetNumUninitialized(File.Num());
+					FLandmarkInstanceData Data;
+					for (int32 i = 0; i < File.Num(); ++i)
+					{
+						File.MakeRecord(i, Data);
+						SlotOf[i] = Store.Add(File.GetKey(i), Data).Index;
+					}
+
+					TUniquePtr<FLandmarkSpatialIndex> Index = MakeUnique<FLandmarkSpatialIndex>();
+					Index->Configure(CellSize, Altitude);
+					File.FillSpatialIndex(*Index, SlotOf);
+				}
+				BinaryTime = FPlatformTime::Seconds() - Start;
+			}
+
+			UE_LOG(LogLandmarkSystem, Log, TEXT("Landmark.Bench.Load N=%d | json %.1f ms (%.1f MB) | lmkb %.1f ms (%.1f MB) | speedup %.1fx"),
+				Count,
+				JsonTime * 1000.0, IFileManager::Get().FileSize(*JsonPath) / (1024.0 * 1024.0),
+				BinaryTime * 1000.0, IFileManager::Get().FileSize(*BinaryPath) / (1024.0 * 1024.0),
+				BinaryTime > 0.0 ? JsonTime / BinaryTime : 0.0);
+
+			IFileManager::Get().Delete(*JsonPath);
+			IFileManager::Get().Delete(*BinaryPath);
+		}
+	}
+
+	/**
+	 * Landmark.Bench.All
+	 * 以默认规模依次运行所有基准，开头记下硬件与构建配置，便于把整段日志作为一次结果记录。
+	 */
+	static void RunAll(const TArray<FString>& Args, UWorld* World)
+	{
+		UE_LOG(LogLandmarkSystem, Log, TEXT("Landmark.Bench.All | %s | %d cores (%d logical) | %s"),
+			*FPlatformMisc::GetCPUBrand().TrimStartAndEnd(),
+			FPlatformMisc::NumberOfCores(), FPlatformMisc::NumberOfCoresIncludingHyperthreads(),
+			LexToString(FApp::GetBuildConfiguration()));
+
+		const TArray<FString> Defaults;
+		RunLoad(Defaults, World);
+		RunJsonParse(Defaults, World);
+		RunProjection(Defaults, World);
+		RunCullScaling(Defaults, World);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs CullScalingCommand(
+		TEXT("Landmark.Bench.CullScaling"),
+		TEXT("Run the landmark cull on a synthetic map split across 1..N worker threads. Args: [Count] (default 200000)"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunCullScaling));
+
+	static FAutoConsoleCommandWithWorldAndArgs ProjectionCommand(
+		TEXT("Landmark.Bench.Projection"),
+		TEXT("Compare per-point ProjectWorldLocationToScreen with the batched landmark projection. Args: [Count...] (default 10000 100000 1000000)"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunProjection));
+
+	static FAutoConsoleCommandWithWorldAndArgs LoadCommand(
+		TEXT("Landmark.Bench.Load"),
+		TEXT("Compare loading the same synthetic landmarks from JSON and from the cooked .lmkb format. Args: [Count...] (default 10000 100000 1000000)"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunLoad));
+
+	static FAutoConsoleCommandWithWorldAndArgs JsonParseCommand(
+		TEXT("Landmark.Bench.JsonParse"),
+		TEXT("Compare the DOM + reflection JSON loader with the streaming landmark reader on one synthetic file. Args: [Count] (default 700000, about 100MB)"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunJsonParse));
+
+	static FAutoConsoleCommandWithWorldAndArgs AllCommand(
+		TEXT("Landmark.Bench.All"),
+		TEXT("Run every landmark benchmark at its default sizes, after logging the CPU and build configuration."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunAll));
+}
+
+#endif // !UE_BUILD_SHIPPING
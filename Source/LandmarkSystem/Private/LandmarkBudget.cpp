@@ -0,0 +1,95 @@
+#include "LandmarkBudget.h"
+#include "LandmarkSettings.h"
+#include "LandmarkSubsystem.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarLandmarkBudgetMs(
+	TEXT("Landmark.Budget.Ms"),
+	-1.0f,
+	TEXT("Label frame budget in milliseconds (cull + draw). <0 uses ULandmarkSettings::LabelBudgetMs, 0 disables the controller."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarLandmarkBudgetForceLevel(
+	TEXT("Landmark.Budget.ForceLevel"),
+	-1,
+	TEXT("Pins the label quality level (0 = full quality). -1 lets the budget controller decide."),
+	ECVF_Cheat);
+
+namespace LandmarkBudget
+{
+	/** 平滑系数：约 10 帧的时间常数 */
+	static constexpr double SmoothingAlpha = 0.1;
+
+	/** 改变级别后至少观察这么多帧再决定下一步 */
+	static constexpr int32 SettleFrames = 15;
+
+	/** 平滑开销低于预算的该比例才回升质量 */
+	static constexpr double RecoverRatio = 0.6;
+}
+
+float FLandmarkBudgetController::GetBudgetMs()
+{
+	const float CVarValue = CVarLandmarkBudgetMs.GetValueOnGameThread();
+	if (CVarValue >= 0.0f)
+	{
+		return CVarValue;
+	}
+	const ULandmarkSettings* Settings = ULandmarkSettings::Get();
+	return Settings ? Settings->LabelBudgetMs : 0.0f;
+}
+
+FLandmarkLabelQuality FLandmarkBudgetController::GetQualityForLevel(int32 InLevel)
+{
+	// 每一级在上一级基础上再降一档
+	const int32 L = FMath::Clamp(InLevel, 0, NumLevels - 1);
+	FLandmarkLabelQuality Q;
+	if (L >= 1) { Q.FarRefreshInterval = 2; }
+	if (L >= 2) { Q.bShowVP = false; }
+	if (L >= 3) { Q.MaxLabels = 512; Q.FarRefreshInterval = 4; }
+	if (L >= 4) { Q.MaxLabels = 256; }
+	if (L >= 5) { Q.MaxLabels = 128; }
+	if (L >= 6) { Q.MinPriority = 1; }
+	return Q;
+}
+
+void FLandmarkBudgetController::SetLevel(int32 NewLevel)
+{
+	NewLevel = FMath::Clamp(NewLevel, 0, NumLevels - 1);
+	if (NewLevel == Level) return;
+
+	UE_LOG(LogLandmarkSystem, Verbose, TEXT("Landmark label budget: level %d -> %d (cost %.2f ms)"), Level, NewLevel, SmoothedCostMs);
+	Level = NewLevel;
+	Quality = GetQualityForLevel(Level);
+	FramesSinceChange = 0;
+}
+
+void FLandmarkBudgetController::EndFrame(float BudgetMs)
+{
+	SmoothedCostMs += (FrameCostMs - SmoothedCostMs) * LandmarkBudget::SmoothingAlpha;
+	FrameCostMs = 0.0;
+	++FramesSinceChange;
+
+	const int32 ForcedLevel = CVarLandmarkBudgetForceLevel.GetValueOnGameThread();
+	if (ForcedLevel >= 0)
+	{
+		SetLevel(ForcedLevel);
+		return;
+	}
+
+	if (BudgetMs <= 0.0f)
+	{
+		SetLevel(0);
+		return;
+	}
+
+	if (FramesSinceChange < LandmarkBudget::SettleFrames) return;
+
+	if (SmoothedCostMs > BudgetMs)
+	{
+		SetLevel(Level + 1);
+	}
+	else if (SmoothedCostMs < BudgetMs * LandmarkBudget::RecoverRatio)
+	{
+		SetLevel(Level - 1);
+	}
+}
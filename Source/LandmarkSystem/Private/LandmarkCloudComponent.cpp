@@ -1,7 +1,7 @@
 #include "LandmarkCloudComponent.h"
 #include "LandmarkSubsystem.h"
-#include "JsonObjectConverter.h"
-#include "Misc/FileHelper.h"
+#include "LandmarkJournal.h"
+#include "HAL/FileManager.h"
 #include "Misc/Paths.h"
 
 ULandmarkCloudComponent::ULandmarkCloudComponent()
@@ -54,20 +54,19 @@ void ULandmarkCloudComponent::LoadFromJson()
     // We are likely in Editor. Can we access Subsystem? Yes, Editor World has Subsystems.
     // But Subsystem loads into "RegisteredLandmarks", we want to load into "Landmarks" TArray.
     // So we need explicit logic here.
+    // 字段按原样读写（不做 X/Y 轴映射），与 SaveToJson 对称
     
     FString RelativePath = FPaths::ProjectContentDir() / TEXT("MapData") / JsonFileName;
-    FString JsonString;
     
-    if (FFileHelper::LoadFileToString(JsonString, *RelativePath))
+    TArray<FLandmarkInstanceData> Loaded;
+    if (FLandmarkJournaledFile::Load(RelativePath, Loaded, false))
     {
-         if (FJsonObjectConverter::JsonArrayStringToUStruct(JsonString, &Landmarks, 0, 0))
-         {
-             UE_LOG(LogTemp, Log, TEXT("LandmarkCloud: Loaded %d points from %s"), Landmarks.Num(), *RelativePath);
-         }
-         else
-         {
-             UE_LOG(LogTemp, Error, TEXT("LandmarkCloud: Failed to parse JSON."));
-         }
+        Landmarks = MoveTemp(Loaded);
+        UE_LOG(LogTemp, Log, TEXT("LandmarkCloud: Loaded %d points from %s"), Landmarks.Num(), *RelativePath);
+    }
+    else if (IFileManager::Get().FileExists(*RelativePath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("LandmarkCloud: Failed to parse JSON."));
     }
     else
     {
@@ -78,34 +77,16 @@ void ULandmarkCloudComponent::LoadFromJson()
 void ULandmarkCloudComponent::SaveToJson()
 {
     FString RelativePath = FPaths::ProjectContentDir() / TEXT("MapData") / JsonFileName;
-    
-    // Manual serialization relying on Subsystem or duplicating logic? 
-    // Let's duplicate or make static helper. Given compilation error, just fix locally.
-    
-    TArray<TSharedPtr<FJsonValue>> JsonArray;
-    
-    for (const FLandmarkInstanceData& Data : Landmarks)
-    {
-        TSharedRef<FJsonObject> JsonObj = MakeShared<FJsonObject>();
-        if (FJsonObjectConverter::UStructToJsonObject(FLandmarkInstanceData::StaticStruct(), &Data, JsonObj, 0, 0))
-        {
-            JsonArray.Add(MakeShared<FJsonValueObject>(JsonObj));
-        }
-    }
 
-    if (JsonArray.Num() > 0)
+    // 第一次保存整体重写，之后只追加改动的点；CompactJson 把日志折叠回文件
+    if (SaveJournal.Save(RelativePath, Landmarks, false))
     {
-        FString JsonString;
-        TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
-        if (FJsonSerializer::Serialize(JsonArray, Writer))
-        {
-            // TextComponent->SetTextRenderColor(VisualConfig.Color.ToFColor(true)); // Color removed?
-            // TextComponent->SetTextRenderColor(FColor::White); // Default white
-            // TextComponent->SetWorldSize(100.0f); // Fixed size
-            if (FFileHelper::SaveStringToFile(JsonString, *RelativePath))
-            {
-                UE_LOG(LogTemp, Log, TEXT("LandmarkCloud: Saved %d points to %s"), Landmarks.Num(), *RelativePath);
-            }
-        }
+        UE_LOG(LogTemp, Log, TEXT("LandmarkCloud: Saved %d points to %s"), Landmarks.Num(), *RelativePath);
     }
 }
+
+void ULandmarkCloudComponent::CompactJson()
+{
+    FString RelativePath = FPaths::ProjectContentDir() / TEXT("MapData") / JsonFileName;
+    FLandmarkJournaledFile::Compact(RelativePath, false);
+}
@@ -59,6 +59,7 @@ void ULandmarkComponent::BeginPlay()
         
         Data.ZMin = MinVisibleHeight;
         Data.ZMax = MaxVisibleHeight;
+        Data.Priority = Priority;
         
         // This component is usually attached to a specific actor (like a City)
         Data.LinkedActor = GetOwner(); 
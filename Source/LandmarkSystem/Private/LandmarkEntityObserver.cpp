@@ -0,0 +1,33 @@
+#include "LandmarkEntityObserver.h"
+#include "LandmarkSubsystem.h"
+#include "LandmarkTypes.h"
+#include "MassExecutionContext.h"
+
+ULandmarkEntityObserver::ULandmarkEntityObserver()
+	: EntityQuery(*this)
+{
+	ObservedType = FLandmarkFragment::StaticStruct();
+	Operation = EMassObservedOperation::Remove;
+	ExecutionFlags = (int32)EProcessorExecutionFlags::All;
+}
+
+void ULandmarkEntityObserver::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager)
+{
+	EntityQuery.AddRequirement<FLandmarkFragment>(EMassFragmentAccess::ReadOnly);
+}
+
+void ULandmarkEntityObserver::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	UWorld* World = EntityManager.GetWorld();
+	ULandmarkSubsystem* Subsystem = World ? World->GetSubsystem<ULandmarkSubsystem>() : nullptr;
+	if (!Subsystem) return;
+
+	EntityQuery.ForEachEntityChunk(Context, [Subsystem](FMassExecutionContext& ChunkContext)
+	{
+		const int32 NumEntities = ChunkContext.GetNumEntities();
+		for (int32 i = 0; i < NumEntities; ++i)
+		{
+			Subsystem->HandleLandmarkEntityRemoved(ChunkContext.GetEntity(i));
+		}
+	});
+}
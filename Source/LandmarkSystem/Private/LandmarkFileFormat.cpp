@@ -0,0 +1,970 @@
+#include "LandmarkFileFormat.h"
+#include "LandmarkSpatialIndex.h"
+#include "LandmarkSubsystem.h"
+#include "Serialization/JsonReader.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Algo/Sort.h"
+
+// --- JSON ---
+
+namespace
+{
+	/**
+	 * Decodes a JSON file (UTF-8, or UTF-16LE with BOM as written by FFileHelper::SaveStringToFile) into TCHARs
+	 * one block at a time, so TJsonReader<TCHAR> can stream it without the whole text in memory.
+	 */
+	class FLandmarkJsonTextStream : public FArchive
+	{
+	public:
+		explicit FLandmarkJsonTextStream(FArchive& InSource)
+			: Source(InSource)
+		{
+			SetIsLoading(true);
+		}
+
+		virtual void Serialize(void* Data, int64 Num) override
+		{
+			TCHAR* Out = static_cast<TCHAR*>(Data);
+			int64 Count = Num / (int64)sizeof(TCHAR);
+			while (Count > 0)
+			{
+				if (Pos == Decoded.Num() && !Refill())
+				{
+					FMemory::Memzero(Out, Count * sizeof(TCHAR));
+					SetError();
+					return;
+				}
+				const int32 Take = (int32)FMath::Min<int64>(Count, Decoded.Num() - Pos);
+				FMemory::Memcpy(Out, Decoded.GetData() + Pos, Take * sizeof(TCHAR));
+				Out += Take;
+				Pos += Take;
+				Count -= Take;
+				Consumed += Take;
+			}
+		}
+
+		virtual bool AtEnd() override
+		{
+			return Pos == Decoded.Num() && !Refill();
+		}
+
+		virtual int64 Tell() override { return Consumed * (int64)sizeof(TCHAR); }
+		virtual FString GetArchiveName() const override { return TEXT("FLandmarkJsonTextStream"); }
+
+	private:
+		enum class EEncoding : uint8 { Unknown, UTF8, UTF16LE };
+
+		static constexpr int64 BlockSize = 64 * 1024;
+
+		bool Refill()
+		{
+			const int64 Remaining = Source.TotalSize() - Source.Tell();
+			if (Remaining <= 0 || Source.IsError()) return false;
+
+			const int32 Carry = Bytes.Num();
+			const int32 Read = (int32)FMath::Min(Remaining, BlockSize);
+			Bytes.SetNumUninitialized(Carry + Read, EAllowShrinking::No);
+			Source.Serialize(Bytes.GetData() + Carry, Read);
+
+			int32 Begin = 0;
+			if (Encoding == EEncoding::Unknown)
+			{
+				if (Bytes.Num() >= 2 && Bytes[0] == 0xFF && Bytes[1] == 0xFE)
+				{
+					Encoding = EEncoding::UTF16LE;
+					Begin = 2;
+				}
+				else
+				{
+					Encoding = EEncoding::UTF8;
+					if (Bytes.Num() >= 3 && Bytes[0] == 0xEF && Bytes[1] == 0xBB && Bytes[2] == 0xBF)
+					{
+						Begin = 3;
+					}
+				}
+			}
+
+			// 只解码完整的字符，块尾被截断的多字节序列 / 代理对留到下一块
+			int32 End = Bytes.Num();
+			const bool bLastBlock = (Read == Remaining);
+			if (Encoding == EEncoding::UTF16LE)
+			{
+				End = Begin + ((End - Begin) & ~1);
+				if (!bLastBlock && End - Begin >= 2)
+				{
+					const uint16 Last = (uint16)(Bytes[End - 2] | (Bytes[End - 1] << 8));
+					if (Last >= 0xD800 && Last <= 0xDBFF) End -= 2;
+				}
+			}
+			else if (!bLastBlock)
+			{
+				for (int32 Back = 1; Back <= 3 && End - Back >= Begin; ++Back)
+				{
+					const uint8 Byte = Bytes[End - Back];
+					if ((Byte & 0xC0) == 0x80) continue;
+					const int32 Length = Byte >= 0xF0 ? 4 : Byte >= 0xE0 ? 3 : Byte >= 0xC0 ? 2 : 1;
+					if (Length > Back) End -= Back;
+					break;
+				}
+			}
+
+			Decoded.Reset();
+			Pos = 0;
+			if (End > Begin)
+			{
+				if (Encoding == EEncoding::UTF16LE)
+				{
+					const auto Converted = StringCast<TCHAR>(reinterpret_cast<const UTF16CHAR*>(Bytes.GetData() + Begin), (End - Begin) / 2);
+					Decoded.Append(Converted.Get(), Converted.Length());
+				}
+				else
+				{
+					const auto Converted = StringCast<TCHAR>(reinterpret_cast<const UTF8CHAR*>(Bytes.GetData() + Begin), End - Begin);
+					Decoded.Append(Converted.Get(), Converted.Length());
+				}
+			}
+			Bytes.RemoveAt(0, End, EAllowShrinking::No);
+			return Decoded.Num() > 0 || Refill();
+		}
+
+		FArchive& Source;
+		EEncoding Encoding = EEncoding::Unknown;
+		TArray<uint8> Bytes;
+		TArray<TCHAR> Decoded;
+		int32 Pos = 0;
+		int64 Consumed = 0;
+	};
+
+	/** Numbers may also be written as strings; booleans count as 0/1. */
+	bool GetJsonNumber(TJsonReader<TCHAR>& Reader, EJsonNotation Notation, double& OutValue)
+	{
+		switch (Notation)
+		{
+		case EJsonNotation::Number:  OutValue = Reader.GetValueAsNumber(); return true;
+		case EJsonNotation::String:  return LexTryParseString(OutValue, *Reader.GetValueAsString());
+		case EJsonNotation::Boolean: OutValue = Reader.GetValueAsBoolean() ? 1.0 : 0.0; return true;
+		default: return false;
+		}
+	}
+
+	/** Skips the value just read if it opened an object or array. */
+	bool SkipJsonValue(TJsonReader<TCHAR>& Reader, EJsonNotation Notation)
+	{
+		if (Notation == EJsonNotation::ObjectStart) return Reader.SkipObject();
+		if (Notation == EJsonNotation::ArrayStart) return Reader.SkipArray();
+		return Notation != EJsonNotation::Error;
+	}
+
+	bool ReadJsonVector(TJsonReader<TCHAR>& Reader, FVector& OutVector)
+	{
+		EJsonNotation Notation;
+		while (Reader.ReadNext(Notation))
+		{
+			if (Notation == EJsonNotation::ObjectEnd) return true;
+
+			const FString& Field = Reader.GetIdentifier();
+			double Number;
+			if (GetJsonNumber(Reader, Notation, Number))
+			{
+				if (Field.Equals(TEXT("X"), ESearchCase::IgnoreCase)) OutVector.X = Number;
+				else if (Field.Equals(TEXT("Y"), ESearchCase::IgnoreCase)) OutVector.Y = Number;
+				else if (Field.Equals(TEXT("Z"), ESearchCase::IgnoreCase)) OutVector.Z = Number;
+			}
+			else if (!SkipJsonValue(Reader, Notation))
+			{
+				return false;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Reads one landmark object (after its ObjectStart) straight into Out.
+	 * 字段名与 FJsonObjectConverter 一样不区分大小写；未知字段（含嵌套对象/数组）直接跳过。
+	 */
+	bool ReadJsonRecord(TJsonReader<TCHAR>& Reader, FLandmarkInstanceData& Out, bool bMapAxes)
+	{
+		EJsonNotation Notation;
+		while (Reader.ReadNext(Notation))
+		{
+			if (Notation == EJsonNotation::ObjectEnd) return true;
+			if (Notation == EJsonNotation::Error) return false;
+
+			const FString& Field = Reader.GetIdentifier();
+			double Number = 0.0;
+
+			if (Notation == EJsonNotation::String && Field.Equals(TEXT("Name"), ESearchCase::IgnoreCase)) Out.Name = Reader.GetValueAsString();
+			else if (Notation == EJsonNotation::String && Field.Equals(TEXT("Type"), ESearchCase::IgnoreCase)) Out.Type = Reader.GetValueAsString();
+			else if (Notation == EJsonNotation::String && Field.Equals(TEXT("ID"), ESearchCase::IgnoreCase)) Out.ID = Reader.GetValueAsString();
+			else if (Notation == EJsonNotation::String && Field.Equals(TEXT("RepresentationClass"), ESearchCase::IgnoreCase))
+			{
+				const FString& Path = Reader.GetValueAsString();
+				Out.RepresentationClass = Path.IsEmpty() ? TSoftClassPtr<AActor>() : TSoftClassPtr<AActor>(FSoftObjectPath(Path));
+			}
+			else if (Notation == EJsonNotation::ObjectStart && Field.Equals(TEXT("VisualOffset"), ESearchCase::IgnoreCase))
+			{
+				if (!ReadJsonVector(Reader, Out.VisualOffset)) return false;
+			}
+			else if (GetJsonNumber(Reader, Notation, Number))
+			{
+				// Correct Coordinate System Mapping: X=Forward(North), Y=Right(East)
+				if (Field.Equals(TEXT("X"), ESearchCase::IgnoreCase)) (bMapAxes ? Out.Y : Out.X) = Number;
+				else if (Field.Equals(TEXT("Y"), ESearchCase::IgnoreCase)) (bMapAxes ? Out.X : Out.Y) = Number;
+				else if (Field.Equals(TEXT("ZMin"), ESearchCase::IgnoreCase)) Out.ZMin = Number;
+				else if (Field.Equals(TEXT("ZMax"), ESearchCase::IgnoreCase)) Out.ZMax = Number;
+				else if (Field.Equals(TEXT("Value"), ESearchCase::IgnoreCase)) Out.Value = (int32)Number;
+				else if (Field.Equals(TEXT("Team"), ESearchCase::IgnoreCase)) Out.Team = (int32)Number;
+				else if (Field.Equals(TEXT("Priority"), ESearchCase::IgnoreCase)) Out.Priority = (int32)Number;
+			}
+			else if (!SkipJsonValue(Reader, Notation))
+			{
+				return false;
+			}
+		}
+		return false;
+	}
+
+	/** Top level: an array of landmark objects. Entries that are not objects are ignored. */
+	bool ReadJsonRecords(TJsonReader<TCHAR>& Reader, TArray<FLandmarkInstanceData>& OutRecords, bool bMapAxes)
+	{
+		EJsonNotation Notation;
+		if (!Reader.ReadNext(Notation) || Notation != EJsonNotation::ArrayStart) return false;
+
+		while (Reader.ReadNext(Notation))
+		{
+			if (Notation == EJsonNotation::ArrayEnd) return true;
+
+			if (Notation == EJsonNotation::ObjectStart)
+			{
+				if (!ReadJsonRecord(Reader, OutRecords.AddDefaulted_GetRef(), bMapAxes)) return false;
+			}
+			else if (!SkipJsonValue(Reader, Notation))
+			{
+				return false;
+			}
+		}
+		return false;
+	}
+}
+
+bool LandmarkFileFormat::ParseJson(const FString& JsonString, TArray<FLandmarkInstanceData>& OutRecords, bool bMapAxes)
+{
+	TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(JsonString);
+	return ReadJsonRecords(*Reader, OutRecords, bMapAxes);
+}
+
+bool LandmarkFileFormat::ReadJsonFile(const FString& Path, TArray<FLandmarkInstanceData>& OutRecords, bool bMapAxes)
+{
+	TUniquePtr<FArchive> File(IFileManager::Get().CreateFileReader(*Path, FILEREAD_Silent));
+	if (!File)
+	{
+		return false;
+	}
+
+	FLandmarkJsonTextStream Stream(*File);
+	TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(&Stream);
+	if (!ReadJsonRecords(*Reader, OutRecords, bMapAxes))
+	{
+		UE_LOG(LogLandmarkSystem, Error, TEXT("LandmarkFileFormat: Failed to parse %s at line %d: %s"), *Path, (int32)Reader->GetLineNumber(), *Reader->GetErrorMessage());
+		return false;
+	}
+	return true;
+}
+
+static void AppendJsonString(FString& Out, const FString& Str)
+{
+	Out += TEXT('"');
+	for (const TCHAR Char : Str)
+	{
+		switch (Char)
+		{
+		case TEXT('"'):  Out += TEXT("\\\""); break;
+		case TEXT('\\'): Out += TEXT("\\\\"); break;
+		case TEXT('\n'): Out += TEXT("\\n"); break;
+		case TEXT('\r'): Out += TEXT("\\r"); break;
+		case TEXT('\t'): Out += TEXT("\\t"); break;
+		default:
+			if (Char < 0x20)
+			{
+				Out += FString::Printf(TEXT("\\u%04x"), (uint32)Char);
+			}
+			else
+			{
+				Out += Char;
+			}
+		}
+	}
+	Out += TEXT('"');
+}
+
+void LandmarkFileFormat::AppendJsonRecord(FString& Out, const FLandmarkInstanceData& Data, bool bMapAxes)
+{
+	Out += TEXT("{\"ID\":");
+	AppendJsonString(Out, Data.ID);
+	Out += TEXT(",\"Name\":");
+	AppendJsonString(Out, Data.Name);
+	Out += TEXT(",\"Type\":");
+	AppendJsonString(Out, Data.Type);
+	Out += FString::Printf(TEXT(",\"X\":%s,\"Y\":%s,\"ZMin\":%s,\"ZMax\":%s,\"Value\":%d,\"Team\":%d,\"Priority\":%d"),
+		*FString::SanitizeFloat(bMapAxes ? Data.Y : Data.X), *FString::SanitizeFloat(bMapAxes ? Data.X : Data.Y),
+		*FString::SanitizeFloat(Data.ZMin), *FString::SanitizeFloat(Data.ZMax), Data.Value, Data.Team, Data.Priority);
+	if (!Data.VisualOffset.IsZero())
+	{
+		Out += FString::Printf(TEXT(",\"VisualOffset\":{\"X\":%s,\"Y\":%s,\"Z\":%s}"),
+			*FString::SanitizeFloat(Data.VisualOffset.X), *FString::SanitizeFloat(Data.VisualOffset.Y), *FString::SanitizeFloat(Data.VisualOffset.Z));
+	}
+	if (!Data.RepresentationClass.IsNull())
+	{
+		Out += TEXT(",\"RepresentationClass\":");
+		AppendJsonString(Out, Data.RepresentationClass.ToSoftObjectPath().ToString());
+	}
+	Out += TEXT('}');
+}
+
+/** Writes Text as UTF-8 and flushes it to the device before returning, so a rename or a later append never sees unwritten data. */
+static bool WriteUtf8File(const FString& Path, const FString& Text, bool bAppend)
+{
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+	const FTCHARToUTF8 Utf8(*Text);
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Path, bAppend));
+	if (!File)
+	{
+		return false;
+	}
+	return File->Write(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length()) && File->Flush(true);
+}
+
+bool LandmarkFileFormat::WriteJsonFile(const FString& Path, const TArray<FLandmarkInstanceData>& Records, bool bMapAxes)
+{
+	// 每行一个对象：人工 diff 友好；先写临时文件再替换，中途崩溃不会留下半个文件
+	FString Text;
+	Text.Reserve(Records.Num() * 192 + 4);
+	Text += TEXT("[\n");
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		Text += TEXT("  ");
+		AppendJsonRecord(Text, Records[i], bMapAxes);
+		Text += (i + 1 < Records.Num()) ? TEXT(",\n") : TEXT("\n");
+	}
+	Text += TEXT("]\n");
+
+	const FString TempPath = Path + TEXT(".tmp");
+	if (!WriteUtf8File(TempPath, Text, false))
+	{
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+		return false;
+	}
+	if (!IFileManager::Get().Move(*Path, *TempPath, true, true))
+	{
+		IFileManager::Get().Delete(*TempPath);
+		return false;
+	}
+	return true;
+}
+
+void LandmarkFileFormat::AssignKeys(const TArray<FLandmarkInstanceData>& Records, TArray<FLandmarkId>& OutKeys)
+{
+	OutKeys.SetNum(Records.Num());
+	TSet<FLandmarkId> UsedKeys;
+	UsedKeys.Reserve(Records.Num());
+
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		const FLandmarkInstanceData& Data = Records[i];
+		FLandmarkId Key;
+		if (Data.ID.IsEmpty())
+		{
+			uint32 Salt = 0;
+			Key = FLandmarkId::FromContent(Data);
+			while (UsedKeys.Contains(Key))
+			{
+				Key = FLandmarkId::FromContent(Data, ++Salt);
+			}
+		}
+		else
+		{
+			Key = FLandmarkId::FromString(Data.ID);
+			if (UsedKeys.Contains(Key))
+			{
+				OutKeys[i] = FLandmarkId(); // 重复 ID：与注册一致，保留第一条
+				continue;
+			}
+		}
+		UsedKeys.Add(Key);
+		OutKeys[i] = Key;
+	}
+}
+
+// --- Journal ---
+
+FString LandmarkFileFormat::GetJournalPath(const FString& BasePath)
+{
+	return FPaths::ChangeExtension(BasePath, JournalExtension);
+}
+
+static const TCHAR* GetJournalOpName(ELandmarkJournalOp Op)
+{
+	switch (Op)
+	{
+	case ELandmarkJournalOp::Add:    return TEXT("Add");
+	case ELandmarkJournalOp::Update: return TEXT("Update");
+	default:                         return TEXT("Remove");
+	}
+}
+
+bool LandmarkFileFormat::AppendJournal(const FString& JournalPath, TConstArrayView<FLandmarkJournalEntry> Entries, const TArray<FLandmarkInstanceData>& Records, bool bMapAxes)
+{
+	if (Entries.Num() == 0) return true;
+
+	FString Text;
+	Text.Reserve(Entries.Num() * 224);
+	for (const FLandmarkJournalEntry& Entry : Entries)
+	{
+		Text += FString::Printf(TEXT("{\"Op\":\"%s\",\"Key\":\"%s\""), GetJournalOpName(Entry.Op), *Entry.Key.ToString());
+		if (Entry.Op != ELandmarkJournalOp::Remove)
+		{
+			Text += TEXT(",\"Data\":");
+			AppendJsonRecord(Text, Records[Entry.Record], bMapAxes);
+		}
+		Text += TEXT("}\n");
+	}
+
+	// 整批一次追加；崩溃最多留下一行不完整的尾部，重放时跳过
+	return WriteUtf8File(JournalPath, Text, true);
+}
+
+int32 LandmarkFileFormat::ReplayJournal(const FString& JournalPath, TArray<FLandmarkInstanceData>& InOutRecords, bool bMapAxes)
+{
+	FString Text;
+	if (!FFileHelper::LoadFileToString(Text, *JournalPath, FFileHelper::EHashOptions::None, FILEREAD_Silent))
+	{
+		return 0;
+	}
+
+	TArray<FLandmarkId> Keys;
+	AssignKeys(InOutRecords, Keys);
+	TMap<FLandmarkId, int32> IndexByKey;
+	IndexByKey.Reserve(Keys.Num());
+	for (int32 i = 0; i < Keys.Num(); ++i)
+	{
+		if (Keys[i].IsSet()) IndexByKey.Add(Keys[i], i);
+	}
+
+	TBitArray<> Removed(false, InOutRecords.Num());
+	int32 NumApplied = 0;
+	int32 LineNumber = 0;
+
+	TArray<FString> Lines;
+	Text.ParseIntoArrayLines(Lines);
+	for (const FString& Line : Lines)
+	{
+		++LineNumber;
+		TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(Line);
+		FString Op;
+		FString KeyString;
+		FLandmarkInstanceData Data;
+		bool bHasData = false;
+		bool bValid = false;
+
+		EJsonNotation Notation;
+		if (Reader->ReadNext(Notation) && Notation == EJsonNotation::ObjectStart)
+		{
+			while (Reader->ReadNext(Notation))
+			{
+				if (Notation == EJsonNotation::ObjectEnd) { bValid = true; break; }
+
+				const FString& Field = Reader->GetIdentifier();
+				if (Notation == EJsonNotation::String && Field.Equals(TEXT("Op"), ESearchCase::IgnoreCase)) Op = Reader->GetValueAsString();
+				else if (Notation == EJsonNotation::String && Field.Equals(TEXT("Key"), ESearchCase::IgnoreCase)) KeyString = Reader->GetValueAsString();
+				else if (Notation == EJsonNotation::ObjectStart && Field.Equals(TEXT("Data"), ESearchCase::IgnoreCase))
+				{
+					if (!ReadJsonRecord(*Reader, Data, bMapAxes)) break;
+					bHasData = true;
+				}
+				else if (!SkipJsonValue(*Reader, Notation)) break;
+			}
+		}
+
+		const FLandmarkId Key = KeyString.IsEmpty() ? FLandmarkId() : FLandmarkId::FromString(KeyString);
+		const bool bRemove = Op.Equals(TEXT("Remove"), ESearchCase::IgnoreCase);
+		if (!bValid || !Key.IsSet() || (!bRemove && !bHasData))
+		{
+			// 通常是写入时崩溃留下的最后一行
+			UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkFileFormat: Skipping malformed journal line %d in %s"), LineNumber, *JournalPath);
+			continue;
+		}
+
+		int32* Existing = IndexByKey.Find(Key);
+		if (bRemove)
+		{
+			if (Existing)
+			{
+				Removed[*Existing] = true;
+				IndexByKey.Remove(Key);
+			}
+		}
+		else if (Existing)
+		{
+			InOutRecords[*Existing] = MoveTemp(Data);
+		}
+		else
+		{
+			IndexByKey.Add(Key, InOutRecords.Add(MoveTemp(Data)));
+			Removed.Add(false);
+		}
+		++NumApplied;
+	}
+
+	// 保持原有顺序删除
+	int32 Write = 0;
+	for (int32 Read = 0; Read < InOutRecords.Num(); ++Read)
+	{
+		if (!Removed[Read])
+		{
+			if (Write != Read) InOutRecords[Write] = MoveTemp(InOutRecords[Read]);
+			++Write;
+		}
+	}
+	InOutRecords.SetNum(Write);
+	return NumApplied;
+}
+
+// --- Binary layout ---
+
+static constexpr uint64 BinarySectionAlignment = 16;
+
+static uint64 GetSectionSize(const FLandmarkBinaryHeader& Header, ELandmarkBinarySection Section)
+{
+	const uint64 N = Header.NumRecords;
+	switch (Section)
+	{
+	case ELandmarkBinarySection::Keys:
+	case ELandmarkBinarySection::X:
+	case ELandmarkBinarySection::Y:
+		return N * 8;
+	case ELandmarkBinarySection::ZMin:
+	case ELandmarkBinarySection::ZMax:
+	case ELandmarkBinarySection::Value:
+	case ELandmarkBinarySection::Team:
+	case ELandmarkBinarySection::Priority:
+	case ELandmarkBinarySection::IdString:
+	case ELandmarkBinarySection::NameString:
+	case ELandmarkBinarySection::TypeString:
+	case ELandmarkBinarySection::RepresentationString:
+		return N * 4;
+	case ELandmarkBinarySection::VisualOffset:
+		return N * 3 * 8;
+	case ELandmarkBinarySection::StringOffsets:
+		return ((uint64)Header.NumStrings + 1) * 4;
+	case ELandmarkBinarySection::StringBlob:
+		return Header.StringBlobSize;
+	case ELandmarkBinarySection::Cells:
+		return (uint64)Header.NumCells * sizeof(FLandmarkBinaryCell);
+	case ELandmarkBinarySection::CellMembers:
+		return (uint64)Header.NumCellMembers * 4;
+	default:
+		return 0;
+	}
+}
+
+uint32 LandmarkFileFormat::HilbertIndex(double X, double Y, const FBox2D& Bounds)
+{
+	static constexpr uint32 Side = 1u << 16;
+
+	const FVector2D Extent = Bounds.GetSize();
+	const double ScaleX = Extent.X > 0.0 ? (Side - 1) / Extent.X : 0.0;
+	const double ScaleY = Extent.Y > 0.0 ? (Side - 1) / Extent.Y : 0.0;
+	uint32 HX = (uint32)FMath::Clamp((X - Bounds.Min.X) * ScaleX, 0.0, (double)(Side - 1));
+	uint32 HY = (uint32)FMath::Clamp((Y - Bounds.Min.Y) * ScaleY, 0.0, (double)(Side - 1));
+
+	uint64 D = 0;
+	for (uint32 S = Side >> 1; S > 0; S >>= 1)
+	{
+		const uint32 RX = (HX & S) ? 1 : 0;
+		const uint32 RY = (HY & S) ? 1 : 0;
+		D += (uint64)S * S * ((3 * RX) ^ RY);
+
+		// 旋转象限，使子曲线首尾相接
+		if (RY == 0)
+		{
+			if (RX == 1)
+			{
+				HX = Side - 1 - HX;
+				HY = Side - 1 - HY;
+			}
+			Swap(HX, HY);
+		}
+	}
+	return (uint32)D;
+}
+
+namespace
+{
+	/** Interned UTF-8 strings; index 0 is the empty string. */
+	struct FLandmarkStringTable
+	{
+		TMap<FString, uint32> IndexByString;
+		TArray<uint32> Offsets;
+		TArray<uint8> Blob;
+
+		FLandmarkStringTable()
+		{
+			Offsets.Add(0);
+			IndexByString.Add(FString(), 0);
+			Offsets.Add(0);
+		}
+
+		int32 Num() const { return Offsets.Num() - 1; }
+
+		uint32 Add(const FString& Str)
+		{
+			if (const uint32* Existing = IndexByString.Find(Str))
+			{
+				return *Existing;
+			}
+			FTCHARToUTF8 Utf8(*Str);
+			Blob.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+			const uint32 Index = (uint32)Num();
+			Offsets.Add((uint32)Blob.Num());
+			IndexByString.Add(Str, Index);
+			return Index;
+		}
+	};
+}
+
+bool LandmarkFileFormat::WriteBinary(const FString& Path, const TArray<FLandmarkInstanceData>& Records, float SpatialBaseCellSize, float SpatialBaseAltitude)
+{
+	// 1. 按输入顺序分配键，规则与 RegisterLandmark 相同，保证与加载 JSON 得到的键一致
+	TArray<FLandmarkId> AllKeys;
+	AssignKeys(Records, AllKeys);
+
+	TArray<int32> Kept;
+	TArray<FLandmarkId> Keys;
+	Kept.Reserve(Records.Num());
+	Keys.Reserve(Records.Num());
+	FBox2D Bounds(ForceInit);
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		if (!AllKeys[i].IsSet()) continue;
+		Kept.Add(i);
+		Keys.Add(AllKeys[i]);
+		Bounds += FVector2D(Records[i].X, Records[i].Y);
+	}
+
+	// 2. Hilbert 排序：空间上相邻的记录在文件和槽位中也相邻
+	TArray<int32> Order;
+	TArray<uint32> Hilbert;
+	Order.SetNumUninitialized(Kept.Num());
+	Hilbert.SetNumUninitialized(Kept.Num());
+	for (int32 i = 0; i < Kept.Num(); ++i)
+	{
+		const FLandmarkInstanceData& Data = Records[Kept[i]];
+		Order[i] = i;
+		Hilbert[i] = HilbertIndex(Data.X, Data.Y, Bounds);
+	}
+	Algo::Sort(Order, [&Hilbert](int32 A, int32 B)
+	{
+		return Hilbert[A] != Hilbert[B] ? Hilbert[A] < Hilbert[B] : A < B;
+	});
+
+	// 3. 预构建空间索引（成员为排序后的记录下标）
+	FLandmarkBinaryHeader Header;
+	Header.Magic = BinaryMagic;
+	Header.Version = BinaryVersion;
+	Header.NumRecords = (uint32)Order.Num();
+
+	TUniquePtr<FLandmarkSpatialIndex> SpatialIndex = MakeUnique<FLandmarkSpatialIndex>();
+	SpatialIndex->Configure(SpatialBaseCellSize, SpatialBaseAltitude);
+	Header.SpatialBaseCellSize = SpatialIndex->GetBaseCellSize();
+	Header.SpatialBaseAltitude = SpatialIndex->GetBaseAltitude();
+	for (int32 i = 0; i < Order.Num(); ++i)
+	{
+		const FLandmarkInstanceData& Data = Records[Kept[Order[i]]];
+		SpatialIndex->Add(i, Data.X, Data.Y, (float)Data.ZMin, (float)Data.ZMax);
+	}
+
+	TArray<FLandmarkBinaryCell> Cells;
+	TArray<uint32> CellMembers;
+	for (int32 Level = 0; Level < FLandmarkSpatialIndex::MaxLevels; ++Level)
+	{
+		const int32 FirstCell = Cells.Num();
+		SpatialIndex->ForEachCell(Level, [&Cells, Level](const FIntPoint& Cell, const FLandmarkSpatialCell&)
+		{
+			Cells.Add({ Level, Cell.X, Cell.Y, 0, 0 });
+		});
+		// TMap 迭代顺序不稳定：按行列排序，同样的输入总是生成同样的文件
+		Algo::Sort(MakeArrayView(Cells.GetData() + FirstCell, Cells.Num() - FirstCell), [](const FLandmarkBinaryCell& A, const FLandmarkBinaryCell& B)
+		{
+			return A.CellY != B.CellY ? A.CellY < B.CellY : A.CellX < B.CellX;
+		});
+		for (int32 c = FirstCell; c < Cells.Num(); ++c)
+		{
+			FLandmarkBinaryCell& Cell = Cells[c];
+			const FLandmarkSpatialCell* Members = SpatialIndex->FindCell(Level, FIntPoint(Cell.CellX, Cell.CellY));
+			Cell.FirstMember = (uint32)CellMembers.Num();
+			Cell.NumMembers = (uint32)Members->Num();
+			// Full 在前，Partial 按 ZMin 升序在后：加载时逐个追加即保持有序
+			for (const int32 Member : Members->Full) CellMembers.Add((uint32)Member);
+			for (const int32 Member : Members->Partial) CellMembers.Add((uint32)Member);
+		}
+	}
+	SpatialIndex.Reset();
+	Header.NumCells = (uint32)Cells.Num();
+	Header.NumCellMembers = (uint32)CellMembers.Num();
+
+	// 4. 字符串表
+	FLandmarkStringTable Strings;
+	TArray<uint32> StringRefs[4];
+	for (TArray<uint32>& Refs : StringRefs)
+	{
+		Refs.SetNumUninitialized(Order.Num());
+	}
+	for (int32 i = 0; i < Order.Num(); ++i)
+	{
+		const FLandmarkInstanceData& Data = Records[Kept[Order[i]]];
+		StringRefs[0][i] = Strings.Add(Data.ID);
+		StringRefs[1][i] = Strings.Add(Data.Name);
+		StringRefs[2][i] = Strings.Add(Data.Type);
+		StringRefs[3][i] = Strings.Add(Data.RepresentationClass.IsNull() ? FString() : Data.RepresentationClass.ToSoftObjectPath().ToString());
+	}
+	Header.NumStrings = (uint32)Strings.Num();
+	Header.StringBlobSize = (uint64)Strings.Blob.Num();
+
+	// 5. 布局
+	uint64 Cursor = Align((uint64)sizeof(FLandmarkBinaryHeader), BinarySectionAlignment);
+	for (int32 Section = 0; Section < (int32)ELandmarkBinarySection::Num; ++Section)
+	{
+		Header.Offsets[Section] = Cursor;
+		Cursor = Align(Cursor + GetSectionSize(Header, (ELandmarkBinarySection)Section), BinarySectionAlignment);
+	}
+
+	TArray64<uint8> Buffer;
+	Buffer.SetNumZeroed((int64)Cursor);
+	uint8* Base = Buffer.GetData();
+	FMemory::Memcpy(Base, &Header, sizeof(Header));
+
+	auto SectionPtr = [Base, &Header](ELandmarkBinarySection Section) { return Base + Header.Offsets[(int32)Section]; };
+	uint64* OutKeys = reinterpret_cast<uint64*>(SectionPtr(ELandmarkBinarySection::Keys));
+	double* OutX = reinterpret_cast<double*>(SectionPtr(ELandmarkBinarySection::X));
+	double* OutY = reinterpret_cast<double*>(SectionPtr(ELandmarkBinarySection::Y));
+	float* OutZMin = reinterpret_cast<float*>(SectionPtr(ELandmarkBinarySection::ZMin));
+	float* OutZMax = reinterpret_cast<float*>(SectionPtr(ELandmarkBinarySection::ZMax));
+	int32* OutValue = reinterpret_cast<int32*>(SectionPtr(ELandmarkBinarySection::Value));
+	int32* OutTeam = reinterpret_cast<int32*>(SectionPtr(ELandmarkBinarySection::Team));
+	int32* OutPriority = reinterpret_cast<int32*>(SectionPtr(ELandmarkBinarySection::Priority));
+	double* OutVisualOffset = reinterpret_cast<double*>(SectionPtr(ELandmarkBinarySection::VisualOffset));
+
+	for (int32 i = 0; i < Order.Num(); ++i)
+	{
+		const FLandmarkInstanceData& Data = Records[Kept[Order[i]]];
+		OutKeys[i] = Keys[Order[i]].Value;
+		OutX[i] = Data.X;
+		OutY[i] = Data.Y;
+		OutZMin[i] = (float)Data.ZMin;
+		OutZMax[i] = (float)Data.ZMax;
+		OutValue[i] = Data.Value;
+		OutTeam[i] = Data.Team;
+		OutPriority[i] = Data.Priority;
+		OutVisualOffset[i * 3 + 0] = Data.VisualOffset.X;
+		OutVisualOffset[i * 3 + 1] = Data.VisualOffset.Y;
+		OutVisualOffset[i * 3 + 2] = Data.VisualOffset.Z;
+	}
+
+	const ELandmarkBinarySection StringSections[4] = { ELandmarkBinarySection::IdString, ELandmarkBinarySection::NameString, ELandmarkBinarySection::TypeString, ELandmarkBinarySection::RepresentationString };
+	for (int32 s = 0; s < 4; ++s)
+	{
+		FMemory::Memcpy(SectionPtr(StringSections[s]), StringRefs[s].GetData(), StringRefs[s].Num() * sizeof(uint32));
+	}
+	FMemory::Memcpy(SectionPtr(ELandmarkBinarySection::StringOffsets), Strings.Offsets.GetData(), Strings.Offsets.Num() * sizeof(uint32));
+	FMemory::Memcpy(SectionPtr(ELandmarkBinarySection::StringBlob), Strings.Blob.GetData(), Strings.Blob.Num());
+	FMemory::Memcpy(SectionPtr(ELandmarkBinarySection::Cells), Cells.GetData(), Cells.Num() * sizeof(FLandmarkBinaryCell));
+	FMemory::Memcpy(SectionPtr(ELandmarkBinarySection::CellMembers), CellMembers.GetData(), CellMembers.Num() * sizeof(uint32));
+
+	if (!FFileHelper::SaveArrayToFile(Buffer, *Path))
+	{
+		UE_LOG(LogLandmarkSystem, Error, TEXT("LandmarkFileFormat: Failed to write %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogLandmarkSystem, Log, TEXT("LandmarkFileFormat: Wrote %d landmarks (%d dropped as duplicates), %d strings, %d cells to %s (%lld bytes)"),
+		Order.Num(), Records.Num() - Order.Num(), Strings.Num(), Cells.Num(), *Path, (int64)Cursor);
+	return true;
+}
+
+// --- FLandmarkBinaryFile ---
+
+FLandmarkBinaryFile::FLandmarkBinaryFile() = default;
+
+FLandmarkBinaryFile::~FLandmarkBinaryFile()
+{
+	Close();
+}
+
+bool FLandmarkBinaryFile::Open(const FString& Path)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	MappedHandle.Reset(PlatformFile.OpenMapped(*Path));
+	if (MappedHandle)
+	{
+		Size = MappedHandle->GetFileSize();
+		MappedRegion.Reset(MappedHandle->MapRegion(0, Size));
+	}
+
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+	}
+	else
+	{
+		// 平台不支持映射（或文件在 pak 中）：整块读入
+		MappedHandle.Reset();
+		if (!FFileHelper::LoadFileToArray(FallbackData, *Path, FILEREAD_Silent))
+		{
+			return false;
+		}
+		Data = FallbackData.GetData();
+		Size = FallbackData.Num();
+	}
+
+	if (!Validate())
+	{
+		UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkFileFormat: %s is not a valid landmark file (version %d expected)"), *Path, LandmarkFileFormat::BinaryVersion);
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void FLandmarkBinaryFile::Close()
+{
+	// 先释放映射区域，再关闭文件句柄
+	MappedRegion.Reset();
+	MappedHandle.Reset();
+	FallbackData.Empty();
+	Data = nullptr;
+	Size = 0;
+	Header = nullptr;
+}
+
+bool FLandmarkBinaryFile::Validate()
+{
+	if (!Data || Size < (int64)sizeof(FLandmarkBinaryHeader)) return false;
+
+	const FLandmarkBinaryHeader* Candidate = reinterpret_cast<const FLandmarkBinaryHeader*>(Data);
+	if (Candidate->Magic != LandmarkFileFormat::BinaryMagic || Candidate->Version != LandmarkFileFormat::BinaryVersion) return false;
+	if (Candidate->NumRecords > (uint32)MAX_int32 || Candidate->NumStrings == 0) return false;
+
+	for (int32 Section = 0; Section < (int32)ELandmarkBinarySection::Num; ++Section)
+	{
+		const uint64 Offset = Candidate->Offsets[Section];
+		const uint64 SectionSize = GetSectionSize(*Candidate, (ELandmarkBinarySection)Section);
+		if (Offset % BinarySectionAlignment != 0 || Offset > (uint64)Size || SectionSize > (uint64)Size - Offset) return false;
+	}
+	Header = Candidate;
+
+	// 下标类数据只在打开时检查一次，之后的访问不再做边界判断
+	const uint32* StringOffsets = GetSection<uint32>(ELandmarkBinarySection::StringOffsets);
+	for (uint32 i = 0; i < Header->NumStrings; ++i)
+	{
+		if (StringOffsets[i] > StringOffsets[i + 1] || StringOffsets[i + 1] > Header->StringBlobSize) return false;
+	}
+
+	const ELandmarkBinarySection StringSections[4] = { ELandmarkBinarySection::IdString, ELandmarkBinarySection::NameString, ELandmarkBinarySection::TypeString, ELandmarkBinarySection::RepresentationString };
+	for (const ELandmarkBinarySection Section : StringSections)
+	{
+		const uint32* Refs = GetSection<uint32>(Section);
+		for (uint32 i = 0; i < Header->NumRecords; ++i)
+		{
+			if (Refs[i] >= Header->NumStrings) return false;
+		}
+	}
+
+	for (const FLandmarkBinaryCell& Cell : GetCells())
+	{
+		if (Cell.Level < 0 || Cell.Level >= FLandmarkSpatialIndex::MaxLevels) return false;
+		if ((uint64)Cell.FirstMember + Cell.NumMembers > Header->NumCellMembers) return false;
+	}
+	const uint32* Members = GetCellMembers();
+	for (uint32 i = 0; i < Header->NumCellMembers; ++i)
+	{
+		if (Members[i] >= Header->NumRecords) return false;
+	}
+	return true;
+}
+
+FString FLandmarkBinaryFile::GetString(uint32 StringIndex) const
+{
+	const uint32* StringOffsets = GetSection<uint32>(ELandmarkBinarySection::StringOffsets);
+	const int32 Begin = (int32)StringOffsets[StringIndex];
+	const int32 Len = (int32)StringOffsets[StringIndex + 1] - Begin;
+	if (Len == 0) return FString();
+
+	const UTF8CHAR* Utf8 = reinterpret_cast<const UTF8CHAR*>(GetSection<uint8>(ELandmarkBinarySection::StringBlob) + Begin);
+	const auto Converted = StringCast<TCHAR>(Utf8, Len);
+	return FString(Converted.Length(), Converted.Get());
+}
+
+void FLandmarkBinaryFile::MakeRecord(int32 Index, FLandmarkInstanceData& Out) const
+{
+	Out.X = GetSection<double>(ELandmarkBinarySection::X)[Index];
+	Out.Y = GetSection<double>(ELandmarkBinarySection::Y)[Index];
+	Out.ZMin = GetSection<float>(ELandmarkBinarySection::ZMin)[Index];
+	Out.ZMax = GetSection<float>(ELandmarkBinarySection::ZMax)[Index];
+	Out.Value = GetSection<int32>(ELandmarkBinarySection::Value)[Index];
+	Out.Team = GetSection<int32>(ELandmarkBinarySection::Team)[Index];
+	Out.Priority = GetSection<int32>(ELandmarkBinarySection::Priority)[Index];
+
+	const double* VisualOffset = GetSection<double>(ELandmarkBinarySection::VisualOffset) + Index * 3;
+	Out.VisualOffset = FVector(VisualOffset[0], VisualOffset[1], VisualOffset[2]);
+
+	Out.ID = GetString(GetSection<uint32>(ELandmarkBinarySection::IdString)[Index]);
+	Out.Name = GetString(GetSection<uint32>(ELandmarkBinarySection::NameString)[Index]);
+	Out.Type = GetString(GetSection<uint32>(ELandmarkBinarySection::TypeString)[Index]);
+
+	const FString Representation = GetString(GetSection<uint32>(ELandmarkBinarySection::RepresentationString)[Index]);
+	Out.RepresentationClass = Representation.IsEmpty() ? TSoftClassPtr<AActor>() : TSoftClassPtr<AActor>(FSoftObjectPath(Representation));
+}
+
+bool FLandmarkBinaryFile::FillSpatialIndex(FLandmarkSpatialIndex& Index, TConstArrayView<int32> SlotOf) const
+{
+	if (Header->SpatialBaseCellSize != Index.GetBaseCellSize() || Header->SpatialBaseAltitude != Index.GetBaseAltitude())
+	{
+		return false;
+	}
+
+	const TConstArrayView<FLandmarkBinaryCell> Cells = GetCells();
+	const uint32* Members = GetCellMembers();
+	const float* ZMin = GetSection<float>(ELandmarkBinarySection::ZMin);
+	const float* ZMax = GetSection<float>(ELandmarkBinarySection::ZMax);
+
+	int32 CellsPerLevel[FLandmarkSpatialIndex::MaxLevels] = {};
+	for (const FLandmarkBinaryCell& Cell : Cells)
+	{
+		++CellsPerLevel[Cell.Level];
+	}
+	for (int32 Level = 0; Level < FLandmarkSpatialIndex::MaxLevels; ++Level)
+	{
+		Index.ReserveCells(Level, CellsPerLevel[Level]);
+	}
+
+	// 成员按 Full、Partial（ZMin 升序）写出，逐个追加即得到与 Add 相同的格子内容
+	for (const FLandmarkBinaryCell& Cell : Cells)
+	{
+		float BandMin, BandMax;
+		Index.GetLevelBand(Cell.Level, BandMin, BandMax);
+		FLandmarkSpatialCell& Target = Index.FindOrAddCell(Cell.Level, FIntPoint(Cell.CellX, Cell.CellY));
+		Target.Reserve(Cell.NumMembers);
+		for (uint32 m = Cell.FirstMember; m < Cell.FirstMember + Cell.NumMembers; ++m)
+		{
+			const uint32 Record = Members[m];
+			Target.AddUnchecked(SlotOf[Record], ZMin[Record], ZMax[Record], BandMin, BandMax);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,227 @@
+#include "LandmarkJournal.h"
+#include "LandmarkSubsystem.h"
+#include "HAL/FileManager.h"
+#include "Hash/CityHash.h"
+
+/** 日志为空、不存在或以换行结尾；否则最后一行是写入中断留下的半行，不能在它后面继续追加 */
+static bool EndsWithCompleteLine(const FString& JournalPath)
+{
+	TUniquePtr<FArchive> File(IFileManager::Get().CreateFileReader(*JournalPath, FILEREAD_Silent));
+	if (!File || File->TotalSize() == 0)
+	{
+		return true;
+	}
+
+	uint8 Last = 0;
+	File->Seek(File->TotalSize() - 1);
+	File->Serialize(&Last, 1);
+	return !File->IsError() && Last == '\n';
+}
+
+bool FLandmarkJournaledFile::Load(const FString& BasePath, TArray<FLandmarkInstanceData>& OutRecords, bool bMapAxes)
+{
+	const FString JournalPath = LandmarkFileFormat::GetJournalPath(BasePath);
+	const bool bHasBase = IFileManager::Get().FileExists(*BasePath);
+	if (!bHasBase && !IFileManager::Get().FileExists(*JournalPath))
+	{
+		return false;
+	}
+
+	if (bHasBase && !LandmarkFileFormat::ReadJsonFile(BasePath, OutRecords, bMapAxes))
+	{
+		return false;
+	}
+
+	const int32 NumOps = LandmarkFileFormat::ReplayJournal(JournalPath, OutRecords, bMapAxes);
+	if (NumOps > 0)
+	{
+		UE_LOG(LogLandmarkSystem, Log, TEXT("LandmarkJournal: Replayed %d operations from %s"), NumOps, *JournalPath);
+	}
+	return true;
+}
+
+bool FLandmarkJournaledFile::Compact(const FString& BasePath, bool bMapAxes)
+{
+	const FString JournalPath = LandmarkFileFormat::GetJournalPath(BasePath);
+	if (!IFileManager::Get().FileExists(*JournalPath))
+	{
+		return true;
+	}
+
+	TArray<FLandmarkInstanceData> Records;
+	if (!Load(BasePath, Records, bMapAxes) || !LandmarkFileFormat::WriteJsonFile(BasePath, Records, bMapAxes))
+	{
+		UE_LOG(LogLandmarkSystem, Error, TEXT("LandmarkJournal: Failed to compact %s"), *BasePath);
+		return false;
+	}
+
+	// 基础文件已原子替换；此处崩溃只会让日志被再重放一次，结果相同
+	IFileManager::Get().Delete(*JournalPath);
+	UE_LOG(LogLandmarkSystem, Log, TEXT("LandmarkJournal: Compacted %s (%d landmarks)"), *BasePath, Records.Num());
+	return true;
+}
+
+bool FLandmarkJournaledFile::Save(const FString& InBasePath, const TArray<FLandmarkInstanceData>& Records, bool bMapAxes)
+{
+	TArray<FLandmarkId> Keys;
+	LandmarkFileFormat::AssignKeys(Records, Keys);
+
+	// 轴约定变了时哈希不再对应磁盘上的记录：按新的约定重新读取基线，而不是整体重写
+	const bool bHasBaseline = (IsBaselineValid(InBasePath) && bMapAxes == bBaseMapAxes) || SeedBaseline(InBasePath, bMapAxes);
+	if (!bHasBaseline || JournalOps > FMath::Max(MinCompactOps, SavedHashes.Num() / 4))
+	{
+		return RewriteBase(InBasePath, Records, Keys, bMapAxes);
+	}
+
+	TMap<FLandmarkId, uint64> NewHashes;
+	NewHashes.Reserve(Records.Num());
+	TArray<FLandmarkJournalEntry> Entries;
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		if (!Keys[i].IsSet()) continue;
+
+		const uint64 Hash = HashRecord(Records[i]);
+		NewHashes.Add(Keys[i], Hash);
+		const uint64* Saved = SavedHashes.Find(Keys[i]);
+		if (!Saved)
+		{
+			Entries.Add({ ELandmarkJournalOp::Add, Keys[i], i });
+		}
+		else if (*Saved != Hash)
+		{
+			Entries.Add({ ELandmarkJournalOp::Update, Keys[i], i });
+		}
+	}
+	for (const TPair<FLandmarkId, uint64>& Pair : SavedHashes)
+	{
+		if (!NewHashes.Contains(Pair.Key))
+		{
+			Entries.Add({ ELandmarkJournalOp::Remove, Pair.Key, INDEX_NONE });
+		}
+	}
+
+	if (Entries.Num() == 0)
+	{
+		return true;
+	}
+
+	const FString JournalPath = LandmarkFileFormat::GetJournalPath(InBasePath);
+	if (!LandmarkFileFormat::AppendJournal(JournalPath, Entries, Records, bMapAxes))
+	{
+		UE_LOG(LogLandmarkSystem, Error, TEXT("LandmarkJournal: Failed to append to %s"), *JournalPath);
+		// 日志尾部状态未知：下次保存整体重写
+		BasePath.Reset();
+		return false;
+	}
+
+	SavedHashes = MoveTemp(NewHashes);
+	JournalSize = IFileManager::Get().FileSize(*JournalPath);
+	JournalOps += Entries.Num();
+	UE_LOG(LogLandmarkSystem, Log, TEXT("LandmarkJournal: Appended %d operations to %s"), Entries.Num(), *JournalPath);
+	return true;
+}
+
+bool FLandmarkJournaledFile::RewriteBase(const FString& InBasePath, const TArray<FLandmarkInstanceData>& Records, const TArray<FLandmarkId>& Keys, bool bMapAxes)
+{
+	BasePath.Reset();
+	if (!LandmarkFileFormat::WriteJsonFile(InBasePath, Records, bMapAxes))
+	{
+		UE_LOG(LogLandmarkSystem, Error, TEXT("LandmarkJournal: Failed to write %s"), *InBasePath);
+		return false;
+	}
+	IFileManager::Get().Delete(*LandmarkFileFormat::GetJournalPath(InBasePath), false, false, true);
+
+	SavedHashes.Reset();
+	SavedHashes.Reserve(Records.Num());
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		if (Keys[i].IsSet())
+		{
+			SavedHashes.Add(Keys[i], HashRecord(Records[i]));
+		}
+	}
+
+	BasePath = InBasePath;
+	bBaseMapAxes = bMapAxes;
+	BaseTimeStamp = IFileManager::Get().GetTimeStamp(*InBasePath);
+	BaseSize = IFileManager::Get().FileSize(*InBasePath);
+	JournalSize = INDEX_NONE;
+	JournalOps = 0;
+	UE_LOG(LogLandmarkSystem, Log, TEXT("LandmarkJournal: Wrote %d landmarks to %s"), Records.Num(), *InBasePath);
+	return true;
+}
+
+bool FLandmarkJournaledFile::SeedBaseline(const FString& InBasePath, bool bMapAxes)
+{
+	BasePath.Reset();
+	IFileManager& FileManager = IFileManager::Get();
+	const FString JournalPath = LandmarkFileFormat::GetJournalPath(InBasePath);
+	if (!FileManager.FileExists(*InBasePath) || !EndsWithCompleteLine(JournalPath))
+	{
+		return false;
+	}
+
+	// 先记时间戳和大小：读取期间文件被改写时，下次保存会发现基线已失效
+	const FDateTime InBaseTimeStamp = FileManager.GetTimeStamp(*InBasePath);
+	const int64 InBaseSize = FileManager.FileSize(*InBasePath);
+	const int64 InJournalSize = FileManager.FileSize(*JournalPath);
+
+	TArray<FLandmarkInstanceData> Records;
+	if (!LandmarkFileFormat::ReadJsonFile(InBasePath, Records, bMapAxes))
+	{
+		return false;
+	}
+	const int32 NumOps = LandmarkFileFormat::ReplayJournal(JournalPath, Records, bMapAxes);
+
+	TArray<FLandmarkId> Keys;
+	LandmarkFileFormat::AssignKeys(Records, Keys);
+	SavedHashes.Reset();
+	SavedHashes.Reserve(Records.Num());
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		if (Keys[i].IsSet())
+		{
+			SavedHashes.Add(Keys[i], HashRecord(Records[i]));
+		}
+	}
+
+	BasePath = InBasePath;
+	bBaseMapAxes = bMapAxes;
+	BaseTimeStamp = InBaseTimeStamp;
+	BaseSize = InBaseSize;
+	JournalSize = InJournalSize;
+	JournalOps = NumOps;
+	UE_LOG(LogLandmarkSystem, Log, TEXT("LandmarkJournal: Resumed %s (%d landmarks, %d journal operations)"), *InBasePath, Records.Num(), NumOps);
+	return true;
+}
+
+bool FLandmarkJournaledFile::IsBaselineValid(const FString& InBasePath) const
+{
+	if (BasePath.IsEmpty() || BasePath != InBasePath) return false;
+
+	IFileManager& FileManager = IFileManager::Get();
+	return FileManager.GetTimeStamp(*InBasePath) == BaseTimeStamp
+		&& FileManager.FileSize(*InBasePath) == BaseSize
+		&& FileManager.FileSize(*LandmarkFileFormat::GetJournalPath(InBasePath)) == JournalSize;
+}
+
+uint64 FLandmarkJournaledFile::HashRecord(const FLandmarkInstanceData& Data)
+{
+	const double Numbers[] = {
+		Data.X, Data.Y, Data.ZMin, Data.ZMax,
+		Data.VisualOffset.X, Data.VisualOffset.Y, Data.VisualOffset.Z,
+		(double)Data.Value, (double)Data.Team, (double)Data.Priority,
+	};
+	uint64 Hash = CityHash64(reinterpret_cast<const char*>(Numbers), sizeof(Numbers));
+
+	for (const FString* Str : { &Data.ID, &Data.Name, &Data.Type })
+	{
+		Hash = CityHash64WithSeed(reinterpret_cast<const char*>(**Str), Str->Len() * sizeof(TCHAR), Hash);
+	}
+	if (!Data.RepresentationClass.IsNull())
+	{
+		const FString Path = Data.RepresentationClass.ToSoftObjectPath().ToString();
+		Hash = CityHash64WithSeed(reinterpret_cast<const char*>(*Path), Path.Len() * sizeof(TCHAR), Hash);
+	}
+	return Hash;
+}
@@ -59,6 +59,7 @@ void ALandmarkMapLabelProxy::BeginPlay()
         
 		Data.ZMin = MinVisibleHeight;
         Data.ZMax = MaxVisibleHeight;
+        Data.Priority = Priority;
 
 		/*
 		Data.LinkedActor = nullptr; // Static proxies don't need link? Or maybe we want to move them?
@@ -49,6 +49,7 @@ void ALandmarkPathGenerator::GenerateLandmarks()
         }
         Data.ZMin = MinVisibleHeight;
         Data.ZMax = MaxVisibleHeight;
+        Data.Priority = Priority;
 		// Link to self? No, these act as independent static points for now.
 		Data.LinkedActor = nullptr; 
 
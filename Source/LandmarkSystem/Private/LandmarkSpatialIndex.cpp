@@ -0,0 +1,171 @@
+#include "LandmarkSpatialIndex.h"
+#include "Algo/BinarySearch.h"
+
+// --- FLandmarkSpatialCell ---
+
+void FLandmarkSpatialCell::GetVisibleAt(float Altitude, TArray<int32>& Out) const
+{
+	if (!IsAnyVisibleAt(Altitude)) return;
+
+	Out.Append(Full);
+
+	// ZMin 升序：只有前缀 [0, End) 满足 ZMin <= Altitude
+	const int32 End = Algo::UpperBound(PartialZMin, Altitude);
+	for (int32 i = 0; i < End; ++i)
+	{
+		if (Altitude <= PartialZMax[i])
+		{
+			Out.Add(Partial[i]);
+		}
+	}
+}
+
+void FLandmarkSpatialCell::Add(int32 Index, float ZMin, float ZMax, float BandMin, float BandMax)
+{
+	if (Full.Contains(Index) || Partial.Contains(Index)) return;
+
+	AddUnchecked(Index, ZMin, ZMax, BandMin, BandMax);
+}
+
+void FLandmarkSpatialCell::AddUnchecked(int32 Index, float ZMin, float ZMax, float BandMin, float BandMax)
+{
+	MinZ = FMath::Min(MinZ, ZMin);
+	MaxZ = FMath::Max(MaxZ, ZMax);
+
+	if (ZMin <= BandMin && ZMax >= BandMax)
+	{
+		Full.Add(Index);
+		FullZMin.Add(ZMin);
+		FullZMax.Add(ZMax);
+		return;
+	}
+
+	const int32 Insert = Algo::UpperBound(PartialZMin, ZMin);
+	Partial.Insert(Index, Insert);
+	PartialZMin.Insert(ZMin, Insert);
+	PartialZMax.Insert(ZMax, Insert);
+}
+
+void FLandmarkSpatialCell::Reserve(int32 Num)
+{
+	Full.Reserve(Num);
+	FullZMin.Reserve(Num);
+	FullZMax.Reserve(Num);
+	Partial.Reserve(Num);
+	PartialZMin.Reserve(Num);
+	PartialZMax.Reserve(Num);
+}
+
+void FLandmarkSpatialCell::Remove(int32 Index)
+{
+	const int32 FullPos = Full.Find(Index);
+	if (FullPos != INDEX_NONE)
+	{
+		Full.RemoveAtSwap(FullPos, 1, EAllowShrinking::No);
+		FullZMin.RemoveAtSwap(FullPos, 1, EAllowShrinking::No);
+		FullZMax.RemoveAtSwap(FullPos, 1, EAllowShrinking::No);
+		RecomputeBounds();
+		return;
+	}
+
+	const int32 PartialPos = Partial.Find(Index);
+	if (PartialPos != INDEX_NONE)
+	{
+		// 保持 ZMin 有序
+		Partial.RemoveAt(PartialPos, 1, EAllowShrinking::No);
+		PartialZMin.RemoveAt(PartialPos, 1, EAllowShrinking::No);
+		PartialZMax.RemoveAt(PartialPos, 1, EAllowShrinking::No);
+		RecomputeBounds();
+	}
+}
+
+void FLandmarkSpatialCell::RecomputeBounds()
+{
+	MinZ = TNumericLimits<float>::Max();
+	MaxZ = TNumericLimits<float>::Lowest();
+	for (int32 i = 0; i < Full.Num(); ++i)
+	{
+		MinZ = FMath::Min(MinZ, FullZMin[i]);
+		MaxZ = FMath::Max(MaxZ, FullZMax[i]);
+	}
+	if (PartialZMin.Num() > 0)
+	{
+		MinZ = FMath::Min(MinZ, PartialZMin[0]);
+	}
+	for (const float ZMax : PartialZMax)
+	{
+		MaxZ = FMath::Max(MaxZ, ZMax);
+	}
+}
+
+// --- FLandmarkSpatialIndex ---
+
+void FLandmarkSpatialIndex::Configure(float InBaseCellSize, float InBaseAltitude)
+{
+	BaseCellSize = FMath::Max(InBaseCellSize, 1.0f);
+	BaseAltitude = FMath::Max(InBaseAltitude, 1.0f);
+	Reset();
+}
+
+void FLandmarkSpatialIndex::Reset()
+{
+	for (FLevel& Level : Levels)
+	{
+		Level.Cells.Reset();
+	}
+}
+
+int32 FLandmarkSpatialIndex::SelectLevel(float Altitude) const
+{
+	if (Altitude < BaseAltitude * 2.0f) return 0;
+	const int32 Level = FMath::FloorToInt(FMath::Log2(Altitude / BaseAltitude));
+	return FMath::Clamp(Level, 0, MaxLevels - 1);
+}
+
+void FLandmarkSpatialIndex::GetLevelBand(int32 Level, float& OutMin, float& OutMax) const
+{
+	// 与 SelectLevel 一致：第 k 层（k >= 1）服务 [Base * 2^k, Base * 2^(k+1))，第 0 层向下不设界
+	OutMin = (Level <= 0) ? TNumericLimits<float>::Lowest() : BaseAltitude * FMath::Pow(2.0f, (float)Level);
+	OutMax = (Level >= MaxLevels - 1) ? TNumericLimits<float>::Max() : BaseAltitude * FMath::Pow(2.0f, (float)(Level + 1));
+}
+
+void FLandmarkSpatialIndex::GetLevelRange(float ZMin, float ZMax, int32& OutFirst, int32& OutLast) const
+{
+	OutFirst = SelectLevel(ZMin);
+	OutLast = SelectLevel(ZMax);
+}
+
+void FLandmarkSpatialIndex::Add(int32 Index, double X, double Y, float ZMin, float ZMax)
+{
+	if (ZMax < ZMin) return; // 任何高度都不可见
+
+	int32 First, Last;
+	GetLevelRange(ZMin, ZMax, First, Last);
+	for (int32 Level = First; Level <= Last; ++Level)
+	{
+		float BandMin, BandMax;
+		GetLevelBand(Level, BandMin, BandMax);
+		Levels[Level].Cells.FindOrAdd(GetCell(Level, X, Y)).Add(Index, ZMin, ZMax, BandMin, BandMax);
+	}
+}
+
+void FLandmarkSpatialIndex::Remove(int32 Index, double X, double Y, float ZMin, float ZMax)
+{
+	if (ZMax < ZMin) return;
+
+	int32 First, Last;
+	GetLevelRange(ZMin, ZMax, First, Last);
+	for (int32 Level = First; Level <= Last; ++Level)
+	{
+		TMap<FIntPoint, FLandmarkSpatialCell>& Cells = Levels[Level].Cells;
+		const FIntPoint Cell = GetCell(Level, X, Y);
+		if (FLandmarkSpatialCell* Members = Cells.Find(Cell))
+		{
+			Members->Remove(Index);
+			if (Members->Num() == 0)
+			{
+				Cells.Remove(Cell);
+			}
+		}
+	}
+}
@@ -0,0 +1,311 @@
+#include "LandmarkStore.h"
+#include "Hash/CityHash.h"
+
+static uint64 HashLandmarkString(const FString& Str, uint64 Seed)
+{
+	FTCHARToUTF8 Utf8(*Str);
+	const uint64 Hash = CityHash64WithSeed(Utf8.Get(), Utf8.Length(), Seed);
+	// 0 保留为"未设置"
+	return Hash != 0 ? Hash : 1;
+}
+
+FLandmarkId FLandmarkId::FromString(const FString& ID)
+{
+	// "#0123456789abcdef" 是 ToString 的输出，直接还原
+	if (ID.Len() == 17 && ID[0] == TEXT('#'))
+	{
+		uint64 Parsed = 0;
+		bool bAllHex = true;
+		for (int32 i = 1; i < ID.Len() && bAllHex; ++i)
+		{
+			bAllHex = FChar::IsHexDigit(ID[i]);
+			Parsed = (Parsed << 4) | (uint64)FParse::HexDigit(ID[i]);
+		}
+		if (bAllHex && Parsed != 0)
+		{
+			return FLandmarkId(Parsed);
+		}
+	}
+
+	// 与旧 TMap<FString> 一致：ID 不区分大小写
+	return FLandmarkId(HashLandmarkString(ID.ToLower(), 0));
+}
+
+FLandmarkId FLandmarkId::FromContent(const FLandmarkInstanceData& Data, uint32 Salt)
+{
+	const FString Content = FString::Printf(TEXT("%s|%s|%.2f|%.2f|%d"),
+		*Data.Type.ToLower(), *Data.Name, Data.X, Data.Y, Data.Team);
+	return FLandmarkId(HashLandmarkString(Content, 0x4C4D4B00ull + Salt));
+}
+
+FString FLandmarkId::ToString() const
+{
+	return FString::Printf(TEXT("#%016llx"), Value);
+}
+
+FLandmarkHandle FLandmarkStore::Add(FLandmarkId Key, const FLandmarkInstanceData& Data)
+{
+	int32 Index;
+	if (FreeSlots.Num() > 0)
+	{
+		Index = FreeSlots.Pop(EAllowShrinking::No);
+		Alive[Index] = true;
+	}
+	else
+	{
+		Index = Alive.Add(true);
+		X.AddUninitialized();
+		Y.AddUninitialized();
+		ZMin.AddUninitialized();
+		ZMax.AddUninitialized();
+		Values.AddUninitialized();
+		Teams.AddUninitialized();
+		Priorities.AddUninitialized();
+		TypeIds.AddUninitialized();
+		// Reset 之后再次启用的槽位沿用（已递增的）代数与修订号
+		if (!Generations.IsValidIndex(Index))
+		{
+			Generations.Add(1);
+			Revisions.Add(0);
+		}
+		Cold.AddDefaulted();
+		Keys.AddDefaulted();
+	}
+
+	WriteSlot(Index, Data);
+	Keys[Index] = Key;
+	SlotByKey.Add(Key, Index);
+	SetEntity(Index, Data.EntityHandle);
+	++NumAlive;
+
+	return FLandmarkHandle(Index, Generations[Index]);
+}
+
+void FLandmarkStore::Set(FLandmarkHandle Handle, const FLandmarkInstanceData& Data)
+{
+	if (!IsValid(Handle)) return;
+
+	WriteSlot(Handle.Index, Data);
+	// Blueprint 无法填写实体句柄：未设置时保留现有绑定
+	if (Data.EntityHandle.IsSet())
+	{
+		SetEntity(Handle.Index, Data.EntityHandle);
+	}
+}
+
+bool FLandmarkStore::Remove(FLandmarkHandle Handle)
+{
+	if (!IsValid(Handle)) return false;
+
+	const int32 Index = Handle.Index;
+	SetEntity(Index, FMassEntityHandle());
+	SlotByKey.Remove(Keys[Index]);
+	Keys[Index] = FLandmarkId();
+	Cold[Index] = FLandmarkColdData();
+
+	Alive[Index] = false;
+	++Generations[Index];
+	FreeSlots.Add(Index);
+	--NumAlive;
+	return true;
+}
+
+void FLandmarkStore::Reset()
+{
+	X.Reset();
+	Y.Reset();
+	ZMin.Reset();
+	ZMax.Reset();
+	Values.Reset();
+	Teams.Reset();
+	Priorities.Reset();
+	TypeIds.Reset();
+	// 代数与修订号不清空：每个槽位递增一次，Reset 之前取得的句柄和按 (槽位, 代数) 缓存的数据永远不会与新地标匹配
+	for (int32& Generation : Generations)
+	{
+		++Generation;
+	}
+	Alive.Reset();
+	FreeSlots.Reset();
+	Cold.Reset();
+	Keys.Reset();
+	SlotByKey.Reset();
+	SlotByEntity.Reset();
+	NumAlive = 0;
+	// 类型表保留：类型 ID 在整个会话内保持稳定
+}
+
+void FLandmarkStore::Reserve(int32 Num)
+{
+	const int32 Total = Alive.Num() + FMath::Max(0, Num - FreeSlots.Num());
+	X.Reserve(Total);
+	Y.Reserve(Total);
+	ZMin.Reserve(Total);
+	ZMax.Reserve(Total);
+	Values.Reserve(Total);
+	Teams.Reserve(Total);
+	Priorities.Reserve(Total);
+	TypeIds.Reserve(Total);
+	Generations.Reserve(Total);
+	Revisions.Reserve(Total);
+	Alive.Reserve(Total);
+	Cold.Reserve(Total);
+	Keys.Reserve(Total);
+	SlotByKey.Reserve(NumAlive + Num);
+}
+
+FLandmarkHandle FLandmarkStore::FindByKey(FLandmarkId Key) const
+{
+	if (const int32* Index = SlotByKey.Find(Key))
+	{
+		return GetHandle(*Index);
+	}
+	return FLandmarkHandle();
+}
+
+void FLandmarkStore::SetEntity(int32 Index, const FMassEntityHandle& Entity)
+{
+	FMassEntityHandle& Current = Cold[Index].EntityHandle;
+	if (Current == Entity) return;
+
+	if (Current.IsSet())
+	{
+		SlotByEntity.Remove(Current);
+	}
+	Current = Entity;
+	if (Entity.IsSet())
+	{
+		// 实体被重新绑定到另一个地标时，旧地标不再指向它
+		if (const int32* Previous = SlotByEntity.Find(Entity))
+		{
+			Cold[*Previous].EntityHandle = FMassEntityHandle();
+		}
+		SlotByEntity.Add(Entity, Index);
+	}
+}
+
+bool FLandmarkStore::ClearEntity(const FMassEntityHandle& Entity)
+{
+	int32 Index = INDEX_NONE;
+	if (!SlotByEntity.RemoveAndCopyValue(Entity, Index)) return false;
+
+	Cold[Index].EntityHandle = FMassEntityHandle();
+	return true;
+}
+
+FLandmarkHandle FLandmarkStore::FindByEntity(const FMassEntityHandle& Entity) const
+{
+	if (const int32* Index = SlotByEntity.Find(Entity))
+	{
+		return GetHandle(*Index);
+	}
+	return FLandmarkHandle();
+}
+
+FLandmarkInstanceData FLandmarkStore::MakeInstanceData(int32 Index) const
+{
+	FLandmarkInstanceData Data;
+	if (!IsAlive(Index)) return Data;
+
+	const FLandmarkColdData& C = Cold[Index];
+	Data.ID = C.ID.IsEmpty() ? Keys[Index].ToString() : C.ID;
+	Data.Name = C.Name;
+	Data.Type = C.Type;
+	Data.X = X[Index];
+	Data.Y = Y[Index];
+	Data.ZMin = ZMin[Index];
+	Data.ZMax = ZMax[Index];
+	Data.Value = Values[Index];
+	Data.Team = Teams[Index];
+	Data.Priority = Priorities[Index];
+	Data.LinkedActor = C.LinkedActor;
+	Data.VisualOffset = C.VisualOffset;
+	Data.RepresentationClass = C.RepresentationClass;
+	Data.EntityHandle = C.EntityHandle;
+	return Data;
+}
+
+FLandmarkSaveSnapshot FLandmarkStore::MakeSaveSnapshot() const
+{
+	FLandmarkSaveSnapshot Snapshot;
+	Snapshot.X.Reserve(NumAlive);
+	Snapshot.Y.Reserve(NumAlive);
+	Snapshot.ZMin.Reserve(NumAlive);
+	Snapshot.ZMax.Reserve(NumAlive);
+	Snapshot.Values.Reserve(NumAlive);
+	Snapshot.Teams.Reserve(NumAlive);
+	Snapshot.Priorities.Reserve(NumAlive);
+	Snapshot.Cold.Reserve(NumAlive);
+
+	ForEachAlive([this, &Snapshot](int32 Index)
+	{
+		Snapshot.X.Add(X[Index]);
+		Snapshot.Y.Add(Y[Index]);
+		Snapshot.ZMin.Add(ZMin[Index]);
+		Snapshot.ZMax.Add(ZMax[Index]);
+		Snapshot.Values.Add(Values[Index]);
+		Snapshot.Teams.Add(Teams[Index]);
+		Snapshot.Priorities.Add(Priorities[Index]);
+
+		const FLandmarkColdData& C = Cold[Index];
+		FLandmarkSaveSnapshot::FColdFields& Out = Snapshot.Cold.AddDefaulted_GetRef();
+		Out.ID = C.ID.IsEmpty() ? Keys[Index].ToString() : C.ID;
+		Out.Name = C.Name;
+		Out.Type = C.Type;
+		Out.VisualOffset = C.VisualOffset;
+		Out.RepresentationClass = C.RepresentationClass;
+	});
+	return Snapshot;
+}
+
+FLandmarkInstanceData FLandmarkSaveSnapshot::MakeInstanceData(int32 I) const
+{
+	FLandmarkInstanceData Data;
+	const FColdFields& C = Cold[I];
+	Data.ID = C.ID;
+	Data.Name = C.Name;
+	Data.Type = C.Type;
+	Data.X = X[I];
+	Data.Y = Y[I];
+	Data.ZMin = ZMin[I];
+	Data.ZMax = ZMax[I];
+	Data.Value = Values[I];
+	Data.Team = Teams[I];
+	Data.Priority = Priorities[I];
+	Data.VisualOffset = C.VisualOffset;
+	Data.RepresentationClass = C.RepresentationClass;
+	return Data;
+}
+
+int32 FLandmarkStore::FindOrAddTypeId(const FString& TypeName)
+{
+	if (const int32* Found = TypeIdByName.Find(TypeName))
+	{
+		return *Found;
+	}
+	const int32 NewId = TypeNames.Add(TypeName);
+	TypeIdByName.Add(TypeName, NewId);
+	return NewId;
+}
+
+void FLandmarkStore::WriteSlot(int32 Index, const FLandmarkInstanceData& Data)
+{
+	X[Index] = Data.X;
+	Y[Index] = Data.Y;
+	ZMin[Index] = (float)Data.ZMin;
+	ZMax[Index] = (float)Data.ZMax;
+	Values[Index] = Data.Value;
+	Teams[Index] = Data.Team;
+	Priorities[Index] = Data.Priority;
+	TypeIds[Index] = FindOrAddTypeId(Data.Type);
+	++Revisions[Index];
+
+	FLandmarkColdData& C = Cold[Index];
+	C.ID = Data.ID;
+	C.Name = Data.Name;
+	C.Type = Data.Type;
+	C.LinkedActor = Data.LinkedActor;
+	C.VisualOffset = Data.VisualOffset;
+	C.RepresentationClass = Data.RepresentationClass;
+	// EntityHandle 由 SetEntity 维护（需同步反向索引）
+}
@@ -0,0 +1,338 @@
+#include "LandmarkStreaming.h"
+#include "LandmarkFileFormat.h"
+#include "LandmarkSubsystem.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+// --- Manifest ---
+
+FString FLandmarkTileManifest::GetTileDirectory(const FString& JsonPath)
+{
+	return FPaths::GetPath(JsonPath) / (FPaths::GetBaseFilename(JsonPath) + TEXT("_Tiles"));
+}
+
+FString FLandmarkTileManifest::GetManifestPath(const FString& TileDirectory)
+{
+	return TileDirectory / TEXT("Tiles.json");
+}
+
+FString FLandmarkTileManifest::GetTilePath(const FIntPoint& Tile) const
+{
+	return Directory / FString::Printf(TEXT("Tile_%d_%d%s"), Tile.X, Tile.Y, LandmarkFileFormat::BinaryExtension);
+}
+
+bool FLandmarkTileManifest::Read(const FString& TileDirectory)
+{
+	// 清单很小（每个瓦片一行），直接用 DOM 解析
+	FString Text;
+	if (!FFileHelper::LoadFileToString(Text, *GetManifestPath(TileDirectory), FFileHelper::EHashOptions::None, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Text), Root) || !Root.IsValid())
+	{
+		return false;
+	}
+
+	int32 FileVersion = 0;
+	double FileTileSize = 0.0;
+	const TArray<TSharedPtr<FJsonValue>>* Entries = nullptr;
+	if (!Root->TryGetNumberField(TEXT("Version"), FileVersion) || FileVersion != Version
+		|| !Root->TryGetNumberField(TEXT("TileSize"), FileTileSize) || FileTileSize <= 0.0
+		|| !Root->TryGetArrayField(TEXT("Tiles"), Entries))
+	{
+		UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkStreaming: %s is not a valid tile manifest (version %d expected)"), *GetManifestPath(TileDirectory), Version);
+		return false;
+	}
+
+	Directory = TileDirectory;
+	TileSize = (float)FileTileSize;
+	Tiles.Reset();
+	Tiles.Reserve(Entries->Num());
+	for (const TSharedPtr<FJsonValue>& Entry : *Entries)
+	{
+		const TSharedPtr<FJsonObject>* Object = nullptr;
+		FIntPoint Tile;
+		FLandmarkTileInfo Info;
+		if (Entry.IsValid() && Entry->TryGetObject(Object)
+			&& (*Object)->TryGetNumberField(TEXT("X"), Tile.X)
+			&& (*Object)->TryGetNumberField(TEXT("Y"), Tile.Y))
+		{
+			(*Object)->TryGetNumberField(TEXT("Num"), Info.NumRecords);
+			(*Object)->TryGetNumberField(TEXT("Bytes"), Info.Bytes);
+			Tiles.Add(Tile, Info);
+		}
+	}
+	return true;
+}
+
+bool FLandmarkTileManifest::Cook(const FString& TileDirectory, const TArray<FLandmarkInstanceData>& Records, float InTileSize, float SpatialBaseCellSize, float SpatialBaseAltitude)
+{
+	if (InTileSize <= 0.0f)
+	{
+		return false;
+	}
+
+	FLandmarkTileManifest Manifest;
+	Manifest.Directory = TileDirectory;
+	Manifest.TileSize = InTileSize;
+
+	// 键对整个文件统一分配，重复 ID 只保留第一条；内容相同的无 ID 条目坐标相同、必在同一块，
+	// 因此每块内部重新分配（WriteBinary）得到的键与整体加载时完全一致
+	TArray<FLandmarkId> Keys;
+	LandmarkFileFormat::AssignKeys(Records, Keys);
+
+	TMap<FIntPoint, TArray<FLandmarkInstanceData>> RecordsByTile;
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		if (Keys[i].IsSet())
+		{
+			RecordsByTile.FindOrAdd(Manifest.GetTile(Records[i].X, Records[i].Y)).Add(Records[i]);
+		}
+	}
+
+	// 旧的瓦片可能已不再存在：整个目录重建
+	IFileManager& FileManager = IFileManager::Get();
+	FileManager.DeleteDirectory(*TileDirectory, false, true);
+	if (!FileManager.MakeDirectory(*TileDirectory, true))
+	{
+		return false;
+	}
+
+	for (const TPair<FIntPoint, TArray<FLandmarkInstanceData>>& Pair : RecordsByTile)
+	{
+		const FString TilePath = Manifest.GetTilePath(Pair.Key);
+		if (!LandmarkFileFormat::WriteBinary(TilePath, Pair.Value, SpatialBaseCellSize, SpatialBaseAltitude))
+		{
+			return false;
+		}
+
+		FLandmarkTileInfo& Info = Manifest.Tiles.Add(Pair.Key);
+		Info.NumRecords = Pair.Value.Num();
+		Info.Bytes = FileManager.FileSize(*TilePath);
+	}
+
+	// 清单最后写入：它的时间戳就是整组瓦片的烘焙时间
+	FString Text = FString::Printf(TEXT("{\n  \"Version\": %d,\n  \"TileSize\": %s,\n  \"Tiles\": [\n"), Version, *FString::SanitizeFloat(InTileSize));
+	int32 NumWritten = 0;
+	for (const TPair<FIntPoint, FLandmarkTileInfo>& Pair : Manifest.Tiles)
+	{
+		Text += FString::Printf(TEXT("    {\"X\": %d, \"Y\": %d, \"Num\": %d, \"Bytes\": %lld}%s\n"),
+			Pair.Key.X, Pair.Key.Y, Pair.Value.NumRecords, Pair.Value.Bytes, ++NumWritten < Manifest.Tiles.Num() ? TEXT(",") : TEXT(""));
+	}
+	Text += TEXT("  ]\n}\n");
+
+	return FFileHelper::SaveStringToFile(Text, *GetManifestPath(TileDirectory), FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
+
+// --- Streamer ---
+
+void FLandmarkTileStreamer::Open(FLandmarkTileManifest&& InManifest)
+{
+	Close();
+	Manifest = MoveTemp(InManifest);
+}
+
+void FLandmarkTileStreamer::Close()
+{
+	for (TPair<FIntPoint, FTileState>& Pair : States)
+	{
+		if (Pair.Value.Task.IsValid())
+		{
+			Pair.Value.Task.Wait();
+		}
+	}
+	States.Reset();
+	Candidates.Reset();
+	Manifest = FLandmarkTileManifest();
+	CommittedBytes = 0;
+	NumResidentTiles = 0;
+	NumLoadingTiles = 0;
+}
+
+int64 FLandmarkTileStreamer::GetTileBytes(const FIntPoint& Tile) const
+{
+	const FLandmarkTileInfo* Info = Manifest.Tiles.Find(Tile);
+	return Info ? Info->Bytes : 0;
+}
+
+void FLandmarkTileStreamer::Update(const FBox2D& Required, const FVector2D& Focus, float Radius, int64 BudgetBytes, TArray<FLandmarkHandle>& OutEvict)
+{
+	if (!IsOpen() || !Required.bIsValid)
+	{
+		return;
+	}
+
+	// 候选：离开加载范围后再多留一个瓦片边长，已常驻的瓦片在这一圈里不卸载
+	const FBox2D InRange = Required.ExpandBy(FMath::Max(0.0f, Radius));
+	const FBox2D KeepRange = InRange.ExpandBy(Manifest.TileSize);
+	const FIntPoint Min = Manifest.GetTile(KeepRange.Min.X, KeepRange.Min.Y);
+	const FIntPoint Max = Manifest.GetTile(KeepRange.Max.X, KeepRange.Max.Y);
+
+	Candidates.Reset();
+	auto AddCandidate = [this, &Required, &InRange, &Focus](const FIntPoint& Tile, const FLandmarkTileInfo& Info)
+	{
+		const FBox2D Bounds = Manifest.GetTileBounds(Tile);
+		FCandidate& Candidate = Candidates.AddDefaulted_GetRef();
+		Candidate.Tile = Tile;
+		Candidate.Bytes = Info.Bytes;
+		Candidate.DistanceSq = Bounds.ComputeSquaredDistanceToPoint(Focus);
+		Candidate.bRequired = Bounds.Intersect(Required);
+		Candidate.bInRange = Bounds.Intersect(InRange);
+	};
+
+	// 探测范围内的瓦片坐标，或遍历清单，取较少的一种
+	const int64 RangeTiles = (int64)(Max.X - Min.X + 1) * (int64)(Max.Y - Min.Y + 1);
+	if (RangeTiles > Manifest.Tiles.Num())
+	{
+		for (const TPair<FIntPoint, FLandmarkTileInfo>& Pair : Manifest.Tiles)
+		{
+			if (Pair.Key.X >= Min.X && Pair.Key.X <= Max.X && Pair.Key.Y >= Min.Y && Pair.Key.Y <= Max.Y)
+			{
+				AddCandidate(Pair.Key, Pair.Value);
+			}
+		}
+	}
+	else
+	{
+		for (int32 TileY = Min.Y; TileY <= Max.Y; ++TileY)
+		{
+			for (int32 TileX = Min.X; TileX <= Max.X; ++TileX)
+			{
+				const FIntPoint Tile(TileX, TileY);
+				if (const FLandmarkTileInfo* Info = Manifest.Tiles.Find(Tile))
+				{
+					AddCandidate(Tile, *Info);
+				}
+			}
+		}
+	}
+
+	// 视野内的瓦片优先，其余由近到远
+	Candidates.Sort([](const FCandidate& A, const FCandidate& B)
+	{
+		if (A.bRequired != B.bRequired) return A.bRequired;
+		return A.DistanceSq < B.DistanceSq;
+	});
+
+	for (TPair<FIntPoint, FTileState>& Pair : States)
+	{
+		Pair.Value.bWanted = false;
+	}
+
+	int64 UsedBytes = 0;
+	for (const FCandidate& Candidate : Candidates)
+	{
+		FTileState* State = States.Find(Candidate.Tile);
+		if (!Candidate.bRequired)
+		{
+			// 保留圈只留住已有的瓦片，不发起新的加载
+			if (!Candidate.bInRange && !State) continue;
+			if (BudgetBytes > 0 && UsedBytes + Candidate.Bytes > BudgetBytes) continue;
+		}
+		UsedBytes += Candidate.Bytes;
+
+		if (State)
+		{
+			State->bWanted = true;
+		}
+		else if (NumLoadingTiles < MaxLoadsInFlight)
+		{
+			StartLoad(Candidate.Tile, States.Add(Candidate.Tile));
+		}
+	}
+
+	// 在途的加载不取消，完成时若仍不需要再丢弃
+	for (auto It = States.CreateIterator(); It; ++It)
+	{
+		FTileState& State = It.Value();
+		if (State.bWanted || !State.bResident) continue;
+
+		OutEvict.Append(State.Handles);
+		CommittedBytes -= GetTileBytes(It.Key());
+		--NumResidentTiles;
+		It.RemoveCurrent();
+	}
+}
+
+void FLandmarkTileStreamer::StartLoad(const FIntPoint& Tile, FTileState& State)
+{
+	State.Load = MakeShared<FLandmarkTileLoad>();
+	State.Load->Tile = Tile;
+	State.Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Load = State.Load, Path = Manifest.GetTilePath(Tile)]()
+	{
+		FLandmarkBinaryFile File;
+		if (!File.Open(Path))
+		{
+			return;
+		}
+
+		const int32 Num = File.Num();
+		Load->Records.SetNum(Num);
+		Load->Keys.SetNumUninitialized(Num);
+		for (int32 i = 0; i < Num; ++i)
+		{
+			File.MakeRecord(i, Load->Records[i]);
+			Load->Keys[i] = File.GetKey(i);
+		}
+		Load->bSuccess = true;
+	});
+
+	CommittedBytes += GetTileBytes(Tile);
+	++NumLoadingTiles;
+}
+
+void FLandmarkTileStreamer::CollectLoaded(TArray<TSharedPtr<FLandmarkTileLoad>>& OutLoaded)
+{
+	if (NumLoadingTiles == 0)
+	{
+		return;
+	}
+
+	for (auto It = States.CreateIterator(); It; ++It)
+	{
+		FTileState& State = It.Value();
+		if (!State.Load.IsValid() || !State.Task.IsCompleted()) continue;
+
+		TSharedPtr<FLandmarkTileLoad> Load = MoveTemp(State.Load);
+		State.Load.Reset();
+		State.Task = UE::Tasks::FTask();
+		--NumLoadingTiles;
+
+		if (!State.bWanted)
+		{
+			CommittedBytes -= GetTileBytes(It.Key());
+			It.RemoveCurrent();
+			continue;
+		}
+
+		if (!Load->bSuccess)
+		{
+			// 视为空的常驻瓦片：不在每次更新时重试，离开范围后才会再次尝试
+			UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkStreaming: Failed to read %s"), *Manifest.GetTilePath(It.Key()));
+			State.bResident = true;
+			++NumResidentTiles;
+			continue;
+		}
+		OutLoaded.Add(MoveTemp(Load));
+	}
+}
+
+void FLandmarkTileStreamer::SetResident(const FIntPoint& Tile, TArray<FLandmarkHandle>&& Handles)
+{
+	FTileState* State = States.Find(Tile);
+	if (!State || State->bResident)
+	{
+		return;
+	}
+
+	State->Handles = MoveTemp(Handles);
+	State->bResident = true;
+	++NumResidentTiles;
+}
@@ -1,11 +1,15 @@
 #include "LandmarkSubsystem.h"
 #include "LandmarkSettings.h"
+#include "LandmarkFileFormat.h"
+#include "LandmarkJournal.h"
+#include "LandmarkStreaming.h"
 #include "Engine/Canvas.h"
 #include "Engine/Engine.h"
 #include "Kismet/GameplayStatics.h"
-#include "JsonObjectConverter.h"
+#include "GameFramework/PlayerController.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
+#include "HAL/FileManager.h"
 #include "Data/RTSCommandGridAsset.h"
 #include "Commands/RTSCityCommands.h"
 // MassBattle
@@ -15,12 +19,56 @@
 #include "MassEntityManager.h"
 #include "MassCommonFragments.h"
 #include "MassEntityUtils.h"
+#include "MassCommands.h"
+#include "MassCommandBuffer.h"
+#include "Async/ParallelFor.h"
+#include "Tasks/Task.h"
+#include "Internationalization/Internationalization.h"
+#include "Algo/Sort.h"
+#include "Misc/ScopeExit.h"
+#if WITH_EDITOR
+#include "DirectoryWatcherModule.h"
+#include "IDirectoryWatcher.h"
+#endif
 
 DEFINE_LOG_CATEGORY(LogLandmarkSystem);
 
+// 锚点略出屏幕的标签（文字向上堆叠）仍需绘制
+static constexpr float LabelScreenMargin = 64.0f;
+
+// 低于一个 8 位颜色级的透明度画出来也看不见；唯一的透明度阈值，剔除时已丢弃，绘制与去重叠不再检查
+static constexpr float MinLabelAlpha = 1.0f / 255.0f;
+
+// 绘制记录的缩放档位：每 1/32 一档，档位内复用同一份布局
+static constexpr float DrawScaleBucketsPerUnit = 32.0f;
+
+// 预算控制降频时，距离超过 MaxDistance 的该比例的标签算作"远处"
+static constexpr float FarLabelDistanceRatio = 0.5f;
+
+// 并行剔除：每块候选数，以及低于该候选数 / 格子数时保持单线程（线程调度开销大于收益）
+static constexpr int32 CullChunkSize = 2048;
+static constexpr int32 ParallelCullMinCandidates = 8192;
+static constexpr int32 ParallelRebuildMinCells = 512;
+
 void ULandmarkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
+
+	if (const ULandmarkSettings* Settings = ULandmarkSettings::Get())
+	{
+		SpatialIndex.Configure(Settings->SpatialBaseCellSize, Settings->SpatialBaseAltitude);
+	}
+
+	// 语言切换时让所有绘制记录失效
+	CultureChangedHandle = FInternationalization::Get().OnCultureChanged().AddUObject(this, &ULandmarkSubsystem::HandleCultureChanged);
+
+	// 世界一创建就在后台读取地图数据，与关卡加载、Actor 初始化重叠
+	const UWorld* World = GetWorld();
+	const ULandmarkSettings* Settings = ULandmarkSettings::Get();
+	if (World && World->IsGameWorld() && Settings && Settings->bAsyncMapDataLoad)
+	{
+		StartMapDataLoad(GetMapDataName(*World));
+	}
 }
 
 // --- VP 默认值辅助函数 ---
@@ -36,19 +84,10 @@ static int32 GetDefaultVictoryPoints(const FString& Type)
 
 void ULandmarkSubsystem::OnWorldBeginPlay(UWorld& InWorld)
 {
-    // 1. 加载 JSON 地标数据
-    FString MapName = InWorld.GetName();
-    MapName.RemoveFromStart(InWorld.StreamingLevelsPrefix);
+    const FString MapName = GetMapDataName(InWorld);
     UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkSubsystem: OnWorldBeginPlay [%s]"), *MapName);
 
-    FString FileName = FString::Printf(TEXT("Landmarks_%s_ZH.json"), *MapName);
-    if (!LoadLandmarksFromFile(FileName))
-    {
-        FileName = FString::Printf(TEXT("Landmarks_%s.json"), *MapName);
-        LoadLandmarksFromFile(FileName);
-    }
-
-    // 2. 注册城市 Command Grid
+    // 1. 注册城市 Command Grid
     // URTSCityCommandGrid 是 C++ 类而非资产，先创建一个共享实例注册给所有城市类型
     // 如果配置文件里填了资产，则以资产为准（覆盖）
     URTSCityCommandGrid* SharedCityGrid = NewObject<URTSCityCommandGrid>(this);
@@ -77,9 +116,23 @@ void ULandmarkSubsystem::OnWorldBeginPlay(UWorld& InWorld)
         UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkSubsystem: No LandmarkSettings found, city grids not registered."));
     }
 
+    // 2. 地图数据：通常已在 Initialize 中开始后台读取；地图名不一致（或未启动）时在此重新开始
+    bWorldBegunPlay = true;
+    if (LoadState == ELandmarkLoadState::Loading && LoadingMapName != MapName)
+    {
+        CancelMapDataLoad();
+    }
+    if (LoadState == ELandmarkLoadState::Idle)
+    {
+        StartMapDataLoad(MapName);
+    }
+    if (Settings && !Settings->bAsyncMapDataLoad)
+    {
+        WaitForLandmarkLoad();
+    }
 
-    // 3. 批量生成所有城市类型的 Mass 实体（一次性，内存高效）
-    BatchSpawnAllCities();
+    // 3. 数据已就绪则立即批量生成所有城市类型的 Mass 实体，否则在后台加载完成时生成
+    TryCompleteMapDataLoad();
 }
 
 void ULandmarkSubsystem::BatchSpawnAllCities()
@@ -91,46 +144,237 @@ void ULandmarkSubsystem::BatchSpawnAllCities()
         return;
     }
 
-    // 按城市等级和阵营分组收集坐标。
     // 地标 JSON 是“单个单位，大量点”；MassUnitInHere 是“一个点，大量单位”。
-    TMap<FString, TMap<int32, TArray<FVector>>> TypeTeamToLocations;
-    for (auto& Pair : RegisteredLandmarks)
+    TArray<int32> Slots;
+    Slots.Reserve(Landmarks.Num());
+    Landmarks.ForEachAlive([&](int32 Index)
+    {
+        if (Landmarks.GetValues()[Index] == 0) Landmarks.SetValue(Index, GetDefaultVictoryPoints(Landmarks.GetCold(Index).Type));
+        Slots.Add(Index);
+    });
+
+    // 专用服务器没有观察者，卡一帧无所谓，且玩法需要实体立即存在
+    UWorld* World = GetWorld();
+    if (Settings->bTimeSliceCitySpawn && World && World->GetNetMode() != NM_DedicatedServer)
     {
-        FLandmarkInstanceData& Data = Pair.Value;
-        if (Data.Value == 0) Data.Value = GetDefaultVictoryPoints(Data.Type);
-        TypeTeamToLocations.FindOrAdd(Data.Type).FindOrAdd(Data.Team).Add(Data.GetLocation());
+        // 从初始相机处由近到远分帧生成；标签已经在绘制，实体在其周围逐步补上
+        CitySpawnFocus = FVector2D::ZeroVector;
+        if (APlayerController* PC = UGameplayStatics::GetPlayerController(World, 0))
+        {
+            FVector ViewLoc;
+            FRotator ViewRot;
+            PC->GetPlayerViewPoint(ViewLoc, ViewRot);
+            CitySpawnFocus = FVector2D(ViewLoc.X, ViewLoc.Y);
+        }
+        QueueCitySpawns(Slots);
+        return;
     }
 
-    // 每个等级、每个阵营批量生成一次
-    for (const FCityLevelConfig& Cfg : Settings->CityLevelConfigs)
+    // 按城市等级和阵营分组，每组批量生成一次；分组时记录的槽位决定句柄写回位置
+    SpawnCityEntities(Slots);
+}
+
+void ULandmarkSubsystem::QueueCitySpawns(TArray<int32>& Slots)
+{
+    if (Slots.Num() == 0) return;
+
+    Algo::SortBy(Slots, [this](int32 Index) { return FVector2D::DistSquared(Landmarks.GetLocation2D(Index), CitySpawnFocus); });
+
+    PendingCitySpawns.Reserve(PendingCitySpawns.Num() + Slots.Num());
+    for (const int32 Index : Slots)
+    {
+        PendingCitySpawns.Add(Landmarks.GetHandle(Index));
+    }
+
+    if (!CitySpawnTickerHandle.IsValid())
+    {
+        CitySpawnTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ULandmarkSubsystem::TickCitySpawns));
+    }
+}
+
+void ULandmarkSubsystem::SpawnQueuedCities(int32 MaxEntities, double BudgetSeconds)
+{
+    // 有时间预算时按小批生成，批与批之间检查耗时；不限时间则剩余的一次生成
+    static constexpr int32 TimeSlicedBatchSize = 256;
+
+    const double StartTime = FPlatformTime::Seconds();
+    int32 NumSpawned = 0;
+    TArray<int32> Batch;
+    while (NextCitySpawn < PendingCitySpawns.Num())
     {
-        TMap<int32, TArray<FVector>>* TeamToLocations = TypeTeamToLocations.Find(Cfg.TypeName);
-        if (!TeamToLocations) continue;
+        int32 BatchLimit = BudgetSeconds > 0.0 ? TimeSlicedBatchSize : MAX_int32;
+        if (MaxEntities > 0)
+        {
+            BatchLimit = FMath::Min(BatchLimit, MaxEntities - NumSpawned);
+        }
 
-        for (auto& TeamPair : *TeamToLocations)
+        Batch.Reset();
+        while (NextCitySpawn < PendingCitySpawns.Num() && Batch.Num() < BatchLimit)
         {
-            const int32 Team = TeamPair.Key;
-            TArray<FVector>& Locations = TeamPair.Value;
-            if (Locations.Num() == 0) continue;
+            // 排队后被注销、或已由重载生成过实体的地标跳过
+            const FLandmarkHandle Handle = PendingCitySpawns[NextCitySpawn++];
+            if (Landmarks.IsValid(Handle) && !Landmarks.GetEntity(Handle.Index).IsSet())
+            {
+                Batch.Add(Handle.Index);
+            }
+        }
+        SpawnCityEntities(Batch);
+        NumSpawned += Batch.Num();
+
+        if (MaxEntities > 0 && NumSpawned >= MaxEntities) break;
+        if (BudgetSeconds > 0.0 && FPlatformTime::Seconds() - StartTime >= BudgetSeconds) break;
+    }
+}
+
+bool ULandmarkSubsystem::TickCitySpawns(float DeltaTime)
+{
+    const ULandmarkSettings* Settings = ULandmarkSettings::Get();
+    SpawnQueuedCities(Settings ? Settings->CitySpawnEntitiesPerFrame : 0, Settings ? Settings->CitySpawnBudgetMs / 1000.0 : 0.0);
+    if (GetNumPendingCitySpawns() > 0)
+    {
+        return true;
+    }
+
+    CitySpawnTickerHandle.Reset();
+    ResetCitySpawnQueue();
+    if (LoadState == ELandmarkLoadState::Spawning)
+    {
+        CompleteLandmarkLoad();
+    }
+    return false;
+}
+
+void ULandmarkSubsystem::FlushPendingCitySpawns()
+{
+    SpawnQueuedCities(0, 0.0);
+    ResetCitySpawnQueue();
+    if (LoadState == ELandmarkLoadState::Spawning)
+    {
+        CompleteLandmarkLoad();
+    }
+}
+
+void ULandmarkSubsystem::ResetCitySpawnQueue()
+{
+    if (CitySpawnTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(CitySpawnTickerHandle);
+        CitySpawnTickerHandle.Reset();
+    }
+    PendingCitySpawns.Reset();
+    NextCitySpawn = 0;
+}
+
+float ULandmarkSubsystem::GetCitySpawnProgress() const
+{
+    if (PendingCitySpawns.Num() > 0)
+    {
+        return (float)NextCitySpawn / PendingCitySpawns.Num();
+    }
+    return IsLandmarkLoadComplete() ? 1.0f : 0.0f;
+}
+
+void ULandmarkSubsystem::BindCityEntity(int32 Index, const FMassEntityHandle& Entity, FMassEntityManager& EntityManager)
+{
+    Landmarks.SetEntity(Index, Entity);
+
+    FLandmarkFragment Fragment;
+    Fragment.LandmarkKey = Landmarks.GetKey(Index).Value;
+    Fragment.VictoryPoints = Landmarks.GetValues()[Index];
+    Fragment.VisualOffset = Landmarks.GetCold(Index).VisualOffset;
+    // 延迟命令按类型批量执行，不会逐个实体迁移原型
+    EntityManager.Defer().PushCommand<FMassCommandAddFragmentInstances>(Entity, Fragment);
+}
+
+void ULandmarkSubsystem::UpdateCityFragment(int32 Index, FMassEntityManager& EntityManager)
+{
+    const FMassEntityHandle& Entity = Landmarks.GetEntity(Index);
+    if (!EntityManager.IsEntityValid(Entity)) return;
+
+    if (FLandmarkFragment* Fragment = EntityManager.GetFragmentDataPtr<FLandmarkFragment>(Entity))
+    {
+        Fragment->VictoryPoints = Landmarks.GetValues()[Index];
+        Fragment->VisualOffset = Landmarks.GetCold(Index).VisualOffset;
+    }
+}
+
+void ULandmarkSubsystem::DestroyCityEntity(int32 Index)
+{
+    const FMassEntityHandle Entity = Landmarks.GetEntity(Index);
+    if (!Entity.IsSet()) return;
+
+    // 先解绑：观察者随后收到的销毁通知不再匹配任何地标
+    Landmarks.SetEntity(Index, FMassEntityHandle());
+    FMassEntityManager* EntityManager = UE::Mass::Utils::GetEntityManager(GetWorld());
+    if (EntityManager && EntityManager->IsEntityValid(Entity))
+    {
+        EntityManager->Defer().DestroyEntity(Entity);
+    }
+}
+
+void ULandmarkSubsystem::SpawnCityEntities(TConstArrayView<int32> Slots)
+{
+    const ULandmarkSettings* Settings = ULandmarkSettings::Get();
+    if (!Settings || Slots.Num() == 0) return;
+
+    // 分组时记下每个坐标来自哪个槽位，生成后按下标直接写回
+    struct FCityGroup
+    {
+        TArray<FVector> Locations;
+        TArray<int32> Slots;
+    };
+    TMap<FString, TMap<int32, FCityGroup>> Groups;
+    for (const int32 Index : Slots)
+    {
+        if (!Landmarks.IsAlive(Index)) continue;
+
+        FCityGroup& Group = Groups.FindOrAdd(Landmarks.GetCold(Index).Type).FindOrAdd(Landmarks.GetTeams()[Index]);
+        const FVector2D Loc = Landmarks.GetLocation2D(Index);
+        Group.Locations.Add(FVector(Loc.X, Loc.Y, 0.0));
+        Group.Slots.Add(Index);
+    }
 
-            TArray<FEntityHandle> Handles = BatchSpawnCityType(Cfg.TypeName, Locations, Team);
-            UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkSubsystem: [%s Team %d] Spawned %d/%d entities."),
-                *Cfg.TypeName, Team, Handles.Num(), Locations.Num());
+    FMassEntityManager* EntityManager = UE::Mass::Utils::GetEntityManager(GetWorld());
+    for (const FCityLevelConfig& Cfg : Settings->CityLevelConfigs)
+    {
+        TMap<int32, FCityGroup>* TeamGroups = Groups.Find(Cfg.TypeName);
+        if (!TeamGroups) continue;
 
-            // 将 Handle 写回 RegisteredLandmarks
-            int32 HandleIdx = 0;
-            for (auto& Pair : RegisteredLandmarks)
+        for (TPair<int32, FCityGroup>& TeamPair : *TeamGroups)
+        {
+            const FCityGroup& Group = TeamPair.Value;
+            // 句柄与 Group.Locations（即 Group.Slots）按下标对应；生成失败的位置是未设置的句柄，对应地标保持无实体
+            const TArray<FEntityHandle> Handles = BatchSpawnCityType(Cfg.TypeName, Group.Locations, TeamPair.Key);
+            check(Handles.Num() == 0 || Handles.Num() == Group.Slots.Num());
+            int32 NumBound = 0;
+            for (int32 i = 0; i < Handles.Num(); ++i)
             {
-                if (HandleIdx >= Handles.Num()) break;
-                if (Pair.Value.Type.Equals(Cfg.TypeName, ESearchCase::IgnoreCase) && Pair.Value.Team == Team)
+                const FMassEntityHandle Entity(Handles[i].Index, Handles[i].Serial);
+                if (!Entity.IsSet()) continue;
+
+                ++NumBound;
+                if (EntityManager)
+                {
+                    BindCityEntity(Group.Slots[i], Entity, *EntityManager);
+                }
+                else
                 {
-                    Pair.Value.EntityHandle = Handles[HandleIdx++];
+                    Landmarks.SetEntity(Group.Slots[i], Entity);
                 }
             }
+            UE_LOG(LogLandmarkSystem, Verbose, TEXT("LandmarkSubsystem: [%s Team %d] Spawned %d/%d entities."),
+                *Cfg.TypeName, TeamPair.Key, NumBound, Group.Locations.Num());
         }
     }
 }
 
+bool ULandmarkSubsystem::IsEntityAlive(const FMassEntityHandle& Entity) const
+{
+    if (!Entity.IsSet()) return false;
+    const FMassEntityManager* EntityManager = UE::Mass::Utils::GetEntityManager(GetWorld());
+    return EntityManager && EntityManager->IsEntityValid(Entity);
+}
+
 TArray<FEntityHandle> ULandmarkSubsystem::BatchSpawnCityType(
     const FString& TypeName, const TArray<FVector>& Locations, int32 Team)
 {
@@ -163,9 +407,11 @@ TArray<FEntityHandle> ULandmarkSubsystem::BatchSpawnCityType(
     FAgentSpawnRectangleShapeData ShapeData;
     ShapeData.Region = FVector2D::ZeroVector; // 精确点位，不散布
 
+    // 每个坐标恰好占一个位置：失败的坐标是未设置的句柄，后面的句柄不会前移
     TArray<FEntityHandle> AllHandles;
     AllHandles.Reserve(Locations.Num());
 
+    int32 NumFailed = 0;
     for (const FVector& Loc : Locations)
     {
         FVector SpawnPos(Loc.X, Loc.Y, Loc.Z);
@@ -174,7 +420,19 @@ TArray<FEntityHandle> ULandmarkSubsystem::BatchSpawnCityType(
             BaseTemplate, 1, Team, SpawnPos, ShapeData,
             FVector2D::ZeroVector, EInitialRotation::CustomRotation, FRotator::ZeroRotator
         );
-        AllHandles.Append(Handles);
+        if (Handles.Num() > 0)
+        {
+            AllHandles.Add(Handles[0]);
+        }
+        else
+        {
+            AllHandles.Add(FEntityHandle());
+            ++NumFailed;
+        }
+    }
+    if (NumFailed > 0)
+    {
+        UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkSubsystem: [%s] %d of %d per-point spawns failed."), *TypeName, NumFailed, Locations.Num());
     }
 
     return AllHandles;
@@ -201,441 +459,1661 @@ URTSCommandGridAsset* ULandmarkSubsystem::GetGridByType(const FString& Type) con
 
 FString ULandmarkSubsystem::FindTypeByEntity(FEntityHandle Handle) const
 {
-    if (Handle.Index == 0) return FString();
-    for (const auto& Pair : RegisteredLandmarks)
-    {
-        const FEntityHandle& Stored = Pair.Value.EntityHandle;
-        if (Stored.Index == Handle.Index && Stored.Serial == Handle.Serial)
-        {
-            return Pair.Value.Type;
-        }
-    }
-    return FString();
+    const FLandmarkHandle Landmark = FindLandmarkByEntity(Handle);
+    return Landmark.IsSet() ? Landmarks.GetCold(Landmark.Index).Type : FString();
+}
+
+FLandmarkHandle ULandmarkSubsystem::FindLandmarkByEntity(FEntityHandle Handle) const
+{
+    if (Handle.Index == 0) return FLandmarkHandle();
+
+    const FMassEntityHandle Entity(Handle.Index, Handle.Serial);
+    const FLandmarkHandle Landmark = Landmarks.FindByEntity(Entity);
+    return (Landmark.IsSet() && IsEntityAlive(Entity)) ? Landmark : FLandmarkHandle();
+}
+
+FEntityHandle ULandmarkSubsystem::FindEntityByLandmark(FLandmarkHandle Handle) const
+{
+    if (!Landmarks.IsValid(Handle)) return FEntityHandle();
+
+    const FMassEntityHandle& Entity = Landmarks.GetEntity(Handle.Index);
+    return IsEntityAlive(Entity) ? FEntityHandle(Entity) : FEntityHandle();
+}
+
+void ULandmarkSubsystem::HandleLandmarkEntityRemoved(const FMassEntityHandle& Entity)
+{
+    // 仅当地标仍绑定在这个实体（Index + Serial 完全一致）时才解除；
+    // 已被替换的旧实体不会误伤新绑定
+    Landmarks.ClearEntity(Entity);
+}
+
+FLandmarkHandle ULandmarkSubsystem::FindLandmarkHandle(const FString& ID) const
+{
+    return Landmarks.FindByID(ID);
+}
+
+FLandmarkHandle ULandmarkSubsystem::FindLandmarkHandleByKey(int64 Key) const
+{
+    return Landmarks.FindByKey(FLandmarkId((uint64)Key));
+}
+
+int64 ULandmarkSubsystem::GetLandmarkKey(FLandmarkHandle Handle) const
+{
+    return Landmarks.IsValid(Handle) ? (int64)Landmarks.GetKey(Handle.Index).Value : 0;
+}
+
+bool ULandmarkSubsystem::IsLandmarkHandleValid(FLandmarkHandle Handle) const
+{
+    return Landmarks.IsValid(Handle);
+}
+
+bool ULandmarkSubsystem::GetLandmarkData(FLandmarkHandle Handle, FLandmarkInstanceData& OutData) const
+{
+    if (!Landmarks.IsValid(Handle)) return false;
+    OutData = Landmarks.MakeInstanceData(Handle.Index);
+    return true;
 }
 
 void ULandmarkSubsystem::Deinitialize()
 {
-	RegisteredLandmarks.Empty();
+	// 工作线程可能仍在读存储
+	if (CullTask.IsValid())
+	{
+		CullTask.Wait();
+		CullTask = UE::Tasks::FTask();
+	}
+	PendingMutations.Reset();
+	TileStreamer.Close();
+
+#if WITH_EDITOR
+	StopWatchingMapFile();
+#endif
+
+	if (LoadState == ELandmarkLoadState::Loading)
+	{
+		CancelMapDataLoad();
+	}
+	ResetCitySpawnQueue();
+
+	// 退出前写完所有排队的保存
+	WaitForPendingSaves();
+
+	FInternationalization::Get().OnCultureChanged().Remove(CultureChangedHandle);
+	DrawRecords.Reset();
+
+	Landmarks.Reset();
+	SpatialIndex.Reset();
 	Super::Deinitialize();
 }
 
-void ULandmarkSubsystem::RegisterLandmark(const FLandmarkInstanceData& Data)
+FLandmarkHandle ULandmarkSubsystem::RegisterLandmark(const FLandmarkInstanceData& Data)
 {
-	FString SafeID = Data.ID;
-	if (SafeID.IsEmpty())
+	if (IsVisibilityUpdateInFlight())
+	{
+		PendingMutations.Add({ ELandmarkMutation::Register, FString(), Data });
+		return FLandmarkHandle();
+	}
+
+	FLandmarkId Key;
+	if (Data.ID.IsEmpty())
+	{
+		// 无 ID：内容哈希，跨运行稳定；内容完全相同的条目按注册顺序加盐区分
+		uint32 Salt = 0;
+		Key = FLandmarkId::FromContent(Data);
+		while (Landmarks.FindByKey(Key).IsSet())
+		{
+			Key = FLandmarkId::FromContent(Data, ++Salt);
+		}
+	}
+	else
 	{
-		SafeID = FGuid::NewGuid().ToString();
+		Key = FLandmarkId::FromString(Data.ID);
 	}
     
     // Check if exists
-    if (RegisteredLandmarks.Contains(SafeID))
+    const FLandmarkHandle Existing = Landmarks.FindByKey(Key);
+    if (Existing.IsSet())
     {
-        FLandmarkInstanceData& Existing = RegisteredLandmarks[SafeID];
         if (Data.LinkedActor.IsValid())
         {
-            Existing.LinkedActor = Data.LinkedActor;
-            if (!Data.Name.IsEmpty()) Existing.Name = Data.Name;
-            if (Existing.Value == 0 && Data.Value > 0) Existing.Value = Data.Value;
+            FLandmarkColdData& Cold = Landmarks.GetMutableCold(Existing.Index);
+            Cold.LinkedActor = Data.LinkedActor;
+            if (!Data.Name.IsEmpty()) Cold.Name = Data.Name;
+            if (Landmarks.GetValues()[Existing.Index] == 0 && Data.Value > 0) Landmarks.SetValue(Existing.Index, Data.Value);
         }
-        return;
+        return Existing;
     }
-	
-	FLandmarkInstanceData NewData = Data;
-	NewData.ID = SafeID;
 
 	// 纯数据注册，城市 Agent 的 Mass Entity 由 SpawnCityAgents 统一创建
-	RegisteredLandmarks.Add(SafeID, NewData);
+	const FLandmarkHandle Handle = Landmarks.Add(Key, Data);
 
     // 更新空间格网
-    if (SpatialCellSize > 0)
-    {
-        FVector Loc = NewData.GetLocation();
-        FIntPoint Cell(FMath::FloorToInt(Loc.X / SpatialCellSize), FMath::FloorToInt(Loc.Y / SpatialCellSize));
-        SpatialGrid.FindOrAdd(Cell).AddUnique(SafeID);
-    }
+    AddToSpatialGrid(Handle.Index);
+    return Handle;
 }
 
 
 
 void ULandmarkSubsystem::UpdateLandmark(const FString& ID, const FLandmarkInstanceData& NewData)
 {
-	if (RegisteredLandmarks.Contains(ID))
+	if (IsVisibilityUpdateInFlight())
+	{
+		PendingMutations.Add({ ELandmarkMutation::Update, ID, NewData });
+		return;
+	}
+
+	const FLandmarkHandle Handle = Landmarks.FindByID(ID);
+	if (Handle.IsSet())
 	{
-		RegisteredLandmarks[ID] = NewData;
+		RemoveFromSpatialGrid(Handle.Index);
+		Landmarks.Set(Handle, NewData);
+		AddToSpatialGrid(Handle.Index);
 	}
 }
 
 void ULandmarkSubsystem::UnregisterLandmark(const FString& ID)
 {
-    // Remove from Spatial Grid first (while we have Data)
-    if (FLandmarkInstanceData* Data = RegisteredLandmarks.Find(ID))
+    if (IsVisibilityUpdateInFlight())
     {
-        if (SpatialCellSize > 0)
-        {
-             FVector Loc = Data->GetLocation();
-             FIntPoint Cell(FMath::FloorToInt(Loc.X / SpatialCellSize), FMath::FloorToInt(Loc.Y / SpatialCellSize));
-             
-             if (TArray<FString>* List = SpatialGrid.Find(Cell))
-             {
-                 List->Remove(ID);
-             }
-        }
+        PendingMutations.Add({ ELandmarkMutation::Unregister, ID, FLandmarkInstanceData() });
+        return;
     }
 
-	RegisteredLandmarks.Remove(ID);
+    const FLandmarkHandle Handle = Landmarks.FindByID(ID);
+    if (!Handle.IsSet()) return;
+
+    // Remove from Spatial Grid first (while we have Data)
+    RemoveFromSpatialGrid(Handle.Index);
+	Landmarks.Remove(Handle);
 }
 
 void ULandmarkSubsystem::UnregisterAll()
 {
-	RegisteredLandmarks.Empty();
+	if (IsVisibilityUpdateInFlight())
+	{
+		// 之前排队的操作全部作废
+		PendingMutations.Reset();
+		PendingMutations.Add({ ELandmarkMutation::UnregisterAll, FString(), FLandmarkInstanceData() });
+		return;
+	}
+
+	// 瓦片登记的句柄随存储一起失效；流式加载到此结束
+	TileStreamer.Close();
+	MapFileKeys.Reset();
+	// 排队的句柄随存储一起失效；生成 ticker 下一帧发现队列已空，照常完成加载
+	PendingCitySpawns.Reset();
+	NextCitySpawn = 0;
+	Landmarks.Reset();
+	SpatialIndex.Reset();
+	// 绘制缓存按槽位索引；去重叠结果引用旧的可见集，下次绘制时重算
+	DrawRecords.Reset();
+	DrawOrder.Reset();
+	DrawOrderKey = FLandmarkDrawOrderKey();
+	bVisibleSetDirty = true;
 }
 
 bool ULandmarkSubsystem::LoadLandmarksFromFile(const FString& FileName)
 {
-    FString RelativePath = FPaths::ProjectContentDir() / TEXT("MapData") / FileName;
-    FString JsonString;
-    
-    if (!FFileHelper::LoadFileToString(JsonString, *RelativePath))
+    FLandmarkLoadResult Result;
+    if (!ReadLandmarkFile(FileName, Result))
     {
-        UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkSubsystem: Failed to load file %s"), *RelativePath);
+        // 后台加载仍在进行时不动它，由它报告自己的结果；已读完、等待 BeginPlay 的加载改为报告失败
+        if (LoadState == ELandmarkLoadState::Loaded)
+        {
+            bMapDataLoaded = false;
+            TryCompleteMapDataLoad();
+        }
         return false;
     }
 
-    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
-    TArray<TSharedPtr<FJsonValue>> JsonArray;
+    // 显式加载优先于尚未完成的地图数据后台加载；读取成功后才取消它
+    if (LoadState == ELandmarkLoadState::Loading)
+    {
+        CancelMapDataLoad();
+        LoadState = ELandmarkLoadState::Loaded;
+    }
+    if (LoadState == ELandmarkLoadState::Loaded)
+    {
+        bMapDataLoaded = true;
+    }
+
+    ApplyLoadResult(Result, true);
+    TryCompleteMapDataLoad();
+    return true;
+}
+
+bool ULandmarkSubsystem::ReadLandmarkFile(const FString& FileName, FLandmarkLoadResult& Out)
+{
+    const double StartTime = FPlatformTime::Seconds();
+    FString RelativePath = FPaths::ProjectContentDir() / TEXT("MapData") / FileName;
+    Out.FileName = FileName;
 
-    if (FJsonSerializer::Deserialize(Reader, JsonArray))
+    // 优先使用烘焙好的二进制文件；JSON 比它新（刚编辑过、还没重新烘焙）时回退到 JSON
+    const FString BinaryPath = FPaths::ChangeExtension(RelativePath, LandmarkFileFormat::BinaryExtension);
+    const FDateTime BinaryTime = IFileManager::Get().GetTimeStamp(*BinaryPath);
+    if (BinaryTime != FDateTime::MinValue())
     {
-        RegisteredLandmarks.Reset();
-        for (const TSharedPtr<FJsonValue>& Value : JsonArray)
+        const FDateTime JsonTime = FMath::Max(IFileManager::Get().GetTimeStamp(*RelativePath), IFileManager::Get().GetTimeStamp(*LandmarkFileFormat::GetJournalPath(RelativePath)));
+        TUniquePtr<FLandmarkBinaryFile> File = MakeUnique<FLandmarkBinaryFile>();
+        if (JsonTime > BinaryTime)
+        {
+            UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkSubsystem: %s is older than %s, loading JSON. Run the LandmarkCook commandlet to refresh it."), *BinaryPath, *FileName);
+        }
+        else if (File->Open(BinaryPath))
         {
-            const TSharedPtr<FJsonObject>* ObjectPtr;
-            if (Value->TryGetObject(ObjectPtr) && ObjectPtr)
+            // 记录按文件顺序（Hilbert 序）读出，键已在烘焙时算好；文件保持打开，注册时直接读取预构建的空间索引
+            const int32 Num = File->Num();
+            Out.Records.SetNum(Num);
+            Out.Keys.SetNumUninitialized(Num);
+            for (int32 i = 0; i < Num; ++i)
             {
-                FLandmarkInstanceData Data;
-                FJsonObjectConverter::JsonObjectToUStruct((*ObjectPtr).ToSharedRef(), &Data);
-                
-                // Correct Coordinate System Mapping: X=Forward(North), Y=Right(East)
-                Data.X = (double)(*ObjectPtr)->GetNumberField(TEXT("Y")); 
-                Data.Y = (double)(*ObjectPtr)->GetNumberField(TEXT("X"));
-                
-                // Fallback ID
-                if (Data.ID.IsEmpty()) Data.ID = FGuid::NewGuid().ToString();
-                
-                // Assign default VP for Cities if missing
+                FLandmarkInstanceData& Data = Out.Records[i];
+                File->MakeRecord(i, Data);
                 if (Data.Value == 0)
                 {
                     Data.Value = GetDefaultVictoryPoints(Data.Type);
                 }
-
-                RegisterLandmark(Data);
+                Out.Keys[i] = File->GetKey(i);
             }
+            Out.CookedFile = MoveTemp(File);
+            Out.ReadSeconds = FPlatformTime::Seconds() - StartTime;
+            return true;
         }
-        
-        FString Msg = FString::Printf(TEXT("LandmarkSystem: Loaded %d landmarks from %s"), RegisteredLandmarks.Num(), *FileName);
-        UE_LOG(LogTemp, Log, TEXT("%s"), *Msg);
-        if (GEngine)
+    }
+
+    if (!IFileManager::Get().FileExists(*RelativePath))
+    {
+        UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkSubsystem: Failed to load file %s"), *RelativePath);
+        return false;
+    }
+
+    // 流式解析：不保留整份文本和 DOM，内存只随记录数增长；随后重放增量保存的日志
+    if (!FLandmarkJournaledFile::Load(RelativePath, Out.Records, true))
+    {
+        UE_LOG(LogLandmarkSystem, Error, TEXT("LandmarkSubsystem: Failed to parse JSON from %s"), *FileName);
+        return false;
+    }
+
+    // 无 ID 的条目由 RegisterLandmark 按内容生成确定性键
+    for (FLandmarkInstanceData& Data : Out.Records)
+    {
+        // Assign default VP for Cities if missing
+        if (Data.Value == 0)
         {
-            GEngine->AddOnScreenDebugMessage(-1, 10.0f, FColor::Green, Msg);
+            Data.Value = GetDefaultVictoryPoints(Data.Type);
         }
-        return true;
     }
-    
-    UE_LOG(LogTemp, Error, TEXT("LandmarkSubsystem: Failed to parse JSON from %s"), *FileName);
-    return false;
+    Out.ReadSeconds = FPlatformTime::Seconds() - StartTime;
+    return true;
 }
 
-bool ULandmarkSubsystem::SaveLandmarksToFile(const FString& FileName, const TArray<FLandmarkInstanceData>& DataToSave)
+void ULandmarkSubsystem::ApplyLoadResult(FLandmarkLoadResult& Result, bool bReplaceExisting)
 {
-    FString RelativePath = FPaths::ProjectContentDir() / TEXT("MapData") / FileName;
-    
-    TArray<TSharedPtr<FJsonValue>> JsonArray;
-    
-    // Manual serialization because UStructArrayToJson might not exist or isn't exposed correctly
-    for (const FLandmarkInstanceData& Data : DataToSave)
+    const double StartTime = FPlatformTime::Seconds();
+
+    // 等待在途剔除落地，而不是把每条记录排进 PendingMutations
+    WaitForVisibilityUpdate();
+    if (bReplaceExisting)
+    {
+        UnregisterAll();
+    }
+
+    MapFileKeys.Reset();
+    MapFileName.Reset();
+    if (Result.TileManifest.IsValid())
     {
-        TSharedRef<FJsonObject> JsonObj = MakeShared<FJsonObject>();
-        if (FJsonObjectConverter::UStructToJsonObject(FLandmarkInstanceData::StaticStruct(), &Data, JsonObj, 0, 0))
+        // 只打开清单：瓦片由 UpdateCameraState 按相机位置加载
+        const int32 NumTiles = Result.TileManifest->Tiles.Num();
+        const float TileSize = Result.TileManifest->TileSize;
+        TileStreamer.Open(MoveTemp(*Result.TileManifest));
+        Result.TileManifest.Reset();
+        UE_LOG(LogLandmarkSystem, Log, TEXT("LandmarkSystem: Streaming %d landmark tiles (%.0f cm) for %s"), NumTiles, TileSize, *Result.FileName);
+        return;
+    }
+
+    const bool bCooked = Result.CookedFile.IsValid() && Result.Keys.Num() == Result.Records.Num();
+    bool bUsedCookedIndex = false;
+    if (bCooked && Landmarks.Num() == 0)
+    {
+        // 空存储：记录写入连续槽位，空间索引参数与烘焙时一致则直接填入预构建的格子
+        const int32 Num = Result.Records.Num();
+        Landmarks.Reserve(Num);
+        TArray<int32> SlotOf;
+        SlotOf.SetNumUninitialized(Num);
+        for (int32 i = 0; i < Num; ++i)
+        {
+            SlotOf[i] = Landmarks.Add(Result.Keys[i], Result.Records[i]).Index;
+        }
+        MapFileKeys.Append(Result.Keys);
+
+        bUsedCookedIndex = Result.CookedFile->FillSpatialIndex(SpatialIndex, SlotOf);
+        if (bUsedCookedIndex)
+        {
+            bVisibleSetDirty = true;
+        }
+        else
         {
-            JsonArray.Add(MakeShared<FJsonValueObject>(JsonObj));
+            for (const int32 Slot : SlotOf)
+            {
+                AddToSpatialGrid(Slot);
+            }
         }
     }
-    
-    if (JsonArray.Num() > 0)
+    else
     {
-        FString JsonString;
-        TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
-        if (FJsonSerializer::Serialize(JsonArray, Writer))
+        // 已有地标（例如场景 Actor 先注册）：逐条注册，同 ID 合并
+        for (const FLandmarkInstanceData& Data : Result.Records)
         {
-            if (FFileHelper::SaveStringToFile(JsonString, *RelativePath))
+            const FLandmarkHandle Handle = RegisterLandmark(Data);
+            if (Handle.IsSet())
             {
-                UE_LOG(LogTemp, Log, TEXT("LandmarkSubsystem: Saved %d landmarks to %s"), DataToSave.Num(), *RelativePath);
-                return true;
+                MapFileKeys.Add(Landmarks.GetKey(Handle.Index));
             }
         }
     }
-    
-    UE_LOG(LogTemp, Error, TEXT("LandmarkSubsystem: Failed to save JSON to %s"), *RelativePath);
-    return false;
-}
+    Result.CookedFile.Reset();
+    MapFileName = Result.FileName;
 
-// --- Spatial Grid Implementation ---
+#if WITH_EDITOR
+    WatchMapFile();
+#endif
 
-void ULandmarkSubsystem::RebuildSpatialGrid()
-{
-    SpatialGrid.Empty();
-    // User Precision Requirement: 256uu cell size
-    SpatialCellSize = 256.0f; 
-
-    for (const auto& Pair : RegisteredLandmarks)
+    FString Msg = FString::Printf(TEXT("LandmarkSystem: Loaded %d landmarks from %s (read %.1f ms, register %.1f ms%s)"), Landmarks.Num(), *Result.FileName,
+        Result.ReadSeconds * 1000.0, (FPlatformTime::Seconds() - StartTime) * 1000.0,
+        !bCooked ? TEXT("") : bUsedCookedIndex ? TEXT(", cooked") : TEXT(", cooked, spatial index rebuilt"));
+    UE_LOG(LogLandmarkSystem, Log, TEXT("%s"), *Msg);
+    if (GEngine)
     {
-        const FLandmarkInstanceData& Data = Pair.Value;
-        FVector Loc = Data.GetLocation();
-        if (Data.LinkedActor.IsValid()) 
-        {
-            Loc = Data.LinkedActor->GetActorLocation();
-        }
-        
-        FIntPoint Cell(FMath::FloorToInt(Loc.X / SpatialCellSize), FMath::FloorToInt(Loc.Y / SpatialCellSize));
-        
-        // Native TMap allows referencing Value directly
-        TArray<FString>& List = SpatialGrid.FindOrAdd(Cell);
-        List.Add(Data.ID);
+        GEngine->AddOnScreenDebugMessage(-1, 10.0f, FColor::Green, Msg);
     }
 }
 
-void ULandmarkSubsystem::UpdateCameraState(const FVector& CameraLocation, const FRotator& CameraRotation, float FOV, float ZoomFactor)
+/** Whether the stored landmark already matches every serialized field of Data. */
+static bool IsSameLandmark(const FLandmarkStore& Store, int32 Index, const FLandmarkInstanceData& Data)
 {
-    // Optimization: Skip if camera stable (User Request: "Simply cache it!")
-    // If camera hasn't moved significant distance or rotated
-    if (FVector::DistSquared(CameraLocation, LastCameraLoc) < 1.0f && CameraRotation.Equals(LastCameraRot, 0.01f))
+    const FLandmarkColdData& Cold = Store.GetCold(Index);
+    return Store.GetX()[Index] == Data.X
+        && Store.GetY()[Index] == Data.Y
+        && Store.GetZMin()[Index] == (float)Data.ZMin
+        && Store.GetZMax()[Index] == (float)Data.ZMax
+        && Store.GetValues()[Index] == Data.Value
+        && Store.GetTeams()[Index] == Data.Team
+        && Store.GetPriorities()[Index] == Data.Priority
+        && Cold.Name.Equals(Data.Name, ESearchCase::CaseSensitive)
+        && Cold.Type.Equals(Data.Type, ESearchCase::CaseSensitive)
+        && Cold.ID.Equals(Data.ID, ESearchCase::CaseSensitive)
+        && Cold.VisualOffset == Data.VisualOffset
+        && Cold.RepresentationClass == Data.RepresentationClass;
+}
+
+bool ULandmarkSubsystem::ReloadLandmarksFromFile(const FString& FileName)
+{
+    const double StartTime = FPlatformTime::Seconds();
+
+    FLandmarkLoadResult Result;
+    if (!ReadLandmarkFile(FileName, Result))
     {
-        return; 
+        return false;
+    }
+    Result.CookedFile.Reset();
+    if (Result.Keys.Num() != Result.Records.Num())
+    {
+        // 与逐条 RegisterLandmark 相同的键（重复 ID 只保留第一条）
+        LandmarkFileFormat::AssignKeys(Result.Records, Result.Keys);
     }
 
-	LastCameraLoc = CameraLocation;
-	LastCameraRot = CameraRotation;
-
-	VisibleLandmarkIDs.Reset();
-	CachedScreenPositions.Reset();
-	CachedScales.Reset();
-	CachedAlphas.Reset();
+    WaitForVisibilityUpdate();
 
-    // Lazy Build
-    if (SpatialGrid.Num() == 0 && RegisteredLandmarks.Num() > 0)
+    // 与上次从同一文件载入的键集合比较；换了文件则不删除任何已有地标
+    TSet<FLandmarkId> PreviousKeys;
+    if (FileName.Equals(MapFileName, ESearchCase::IgnoreCase))
     {
-        RebuildSpatialGrid();
+        PreviousKeys = MoveTemp(MapFileKeys);
     }
+    MapFileName = FileName;
+    MapFileKeys.Reset();
+    MapFileKeys.Reserve(Result.Records.Num());
+
+    // 城市已生成过（或正在分帧生成）才需要补生成；否则 BatchSpawnAllCities 之后会统一生成
+    const bool bCitiesSpawned = LoadState == ELandmarkLoadState::Ready || LoadState == ELandmarkLoadState::Spawning;
+    FMassEntityManager* EntityManager = UE::Mass::Utils::GetEntityManager(GetWorld());
+
+    TArray<int32> SpawnSlots;
+    int32 NumAdded = 0;
+    int32 NumChanged = 0;
+    int32 NumRemoved = 0;
+    for (int32 i = 0; i < Result.Records.Num(); ++i)
+    {
+        const FLandmarkId Key = Result.Keys[i];
+        if (!Key.IsSet()) continue;
 
-	// Calculate Visible Cell Range
-    // Simple heuristic: frustum roughly covers Height * AspectRatio on ground.
-    // Assume max aspect 2.0 (Ultrawide). Radius ~= Height * 1.5.
-    float SearchRadius = FMath::Max(20000.0f, CameraLocation.Z * 2.0f); 
-    int32 CellRadius = FMath::CeilToInt(SearchRadius / SpatialCellSize);
-    
-    // Clamp radius for the 256uu high-density grid. 
-    // Max 40 cells = ~10km search.
-    if (CellRadius > 40) CellRadius = 40; 
+        MapFileKeys.Add(Key);
+        PreviousKeys.Remove(Key);
+        const FLandmarkInstanceData& Data = Result.Records[i];
+
+        const FLandmarkHandle Handle = Landmarks.FindByKey(Key);
+        if (!Handle.IsSet())
+        {
+            const FLandmarkHandle Added = Landmarks.Add(Key, Data);
+            AddToSpatialGrid(Added.Index);
+            SpawnSlots.Add(Added.Index);
+            ++NumAdded;
+            continue;
+        }
+
+        // 未改动的地标：句柄、实体、绘制缓存都不动
+        const int32 Index = Handle.Index;
+        if (IsSameLandmark(Landmarks, Index, Data)) continue;
+        ++NumChanged;
+
+        const bool bMoved = Landmarks.GetX()[Index] != Data.X || Landmarks.GetY()[Index] != Data.Y;
+        const bool bReindex = bMoved || Landmarks.GetZMin()[Index] != (float)Data.ZMin || Landmarks.GetZMax()[Index] != (float)Data.ZMax;
+        const bool bRespawn = bMoved || Landmarks.GetTeams()[Index] != Data.Team || !Landmarks.GetCold(Index).Type.Equals(Data.Type, ESearchCase::IgnoreCase);
+
+        if (bReindex)
+        {
+            RemoveFromSpatialGrid(Index);
+        }
+        // 场景 Actor 的链接由 Actor 自己维护；实体绑定由 Set 保留
+        FLandmarkInstanceData NewData = Data;
+        NewData.LinkedActor = Landmarks.GetCold(Index).LinkedActor;
+        Landmarks.Set(Handle, NewData);
+        bVisibleSetDirty = true;
+        if (bReindex)
+        {
+            AddToSpatialGrid(Index);
+        }
+
+        if (bRespawn)
+        {
+            DestroyCityEntity(Index);
+            SpawnSlots.Add(Index);
+        }
+        else if (EntityManager)
+        {
+            UpdateCityFragment(Index, *EntityManager);
+        }
+    }
+
+    // 从文件中删掉的地标；仍链接着场景 Actor 的由 Actor 负责注销
+    for (const FLandmarkId& Key : PreviousKeys)
+    {
+        const FLandmarkHandle Handle = Landmarks.FindByKey(Key);
+        if (!Handle.IsSet() || Landmarks.GetCold(Handle.Index).LinkedActor.IsValid()) continue;
+
+        DestroyCityEntity(Handle.Index);
+        RemoveFromSpatialGrid(Handle.Index);
+        Landmarks.Remove(Handle);
+        ++NumRemoved;
+    }
+
+    if (LoadState == ELandmarkLoadState::Spawning)
+    {
+        QueueCitySpawns(SpawnSlots);
+    }
+    else if (bCitiesSpawned)
+    {
+        SpawnCityEntities(SpawnSlots);
+    }
+
+    UE_LOG(LogLandmarkSystem, Log, TEXT("LandmarkSystem: Reloaded %s in %.1f ms (%d added, %d changed, %d removed, %d entities respawned)"), *FileName,
+        (FPlatformTime::Seconds() - StartTime) * 1000.0, NumAdded, NumChanged, NumRemoved, bCitiesSpawned ? SpawnSlots.Num() : 0);
+    return true;
+}
+
+#if WITH_EDITOR
+void ULandmarkSubsystem::WatchMapFile()
+{
+    const ULandmarkSettings* Settings = ULandmarkSettings::Get();
+    const UWorld* World = GetWorld();
+    if (MapDataWatcherHandle.IsValid() || !GIsEditor || !World || !World->IsGameWorld() || !Settings || !Settings->bHotReloadMapData)
+    {
+        return;
+    }
+
+    FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+    if (IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get())
+    {
+        WatchedDirectory = FPaths::ProjectContentDir() / TEXT("MapData");
+        DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(WatchedDirectory,
+            IDirectoryWatcher::FDirectoryChanged::CreateUObject(this, &ULandmarkSubsystem::HandleMapDataChanged), MapDataWatcherHandle);
+    }
+}
+
+void ULandmarkSubsystem::StopWatchingMapFile()
+{
+    if (HotReloadTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(HotReloadTickerHandle);
+        HotReloadTickerHandle.Reset();
+    }
+    if (MapDataWatcherHandle.IsValid())
+    {
+        if (FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher")))
+        {
+            if (IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule->Get())
+            {
+                DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle(WatchedDirectory, MapDataWatcherHandle);
+            }
+        }
+        MapDataWatcherHandle.Reset();
+    }
+}
+
+void ULandmarkSubsystem::HandleMapDataChanged(const TArray<FFileChangeData>& Changes)
+{
+    if (MapFileName.IsEmpty() || HotReloadTickerHandle.IsValid())
+    {
+        return;
+    }
+
+    // 保存通常产生多个事件（临时文件、改名、日志追加）：短暂延迟后只重载一次
+    const FString JournalName = FPaths::GetCleanFilename(LandmarkFileFormat::GetJournalPath(MapFileName));
+    for (const FFileChangeData& Change : Changes)
+    {
+        const FString Changed = FPaths::GetCleanFilename(Change.Filename);
+        if (Changed.Equals(MapFileName, ESearchCase::IgnoreCase) || Changed.Equals(JournalName, ESearchCase::IgnoreCase))
+        {
+            HotReloadTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ULandmarkSubsystem::TickHotReload), 0.25f);
+            return;
+        }
+    }
+}
+
+bool ULandmarkSubsystem::TickHotReload(float DeltaTime)
+{
+    HotReloadTickerHandle.Reset();
+    ReloadLandmarksFromFile(MapFileName);
+    return false;
+}
+#endif
+
+// --- Map data loading ---
+
+FString ULandmarkSubsystem::GetMapDataName(const UWorld& World)
+{
+    FString MapName = World.GetName();
+    MapName.RemoveFromStart(World.StreamingLevelsPrefix);
+    return MapName;
+}
+
+void ULandmarkSubsystem::ReadMapData(const FString& MapName, bool bStreamTiles, FLandmarkLoadResult& Out)
+{
+    const FString FileNames[] = { FString::Printf(TEXT("Landmarks_%s_ZH.json"), *MapName), FString::Printf(TEXT("Landmarks_%s.json"), *MapName) };
+    for (const FString& FileName : FileNames)
+    {
+        Out = FLandmarkLoadResult();
+        Out.bSuccess = (bStreamTiles && ReadLandmarkTiles(FileName, Out)) || ReadLandmarkFile(FileName, Out);
+        if (Out.bSuccess)
+        {
+            return;
+        }
+    }
+}
+
+bool ULandmarkSubsystem::ReadLandmarkTiles(const FString& FileName, FLandmarkLoadResult& Out)
+{
+    FString RelativePath = FPaths::ProjectContentDir() / TEXT("MapData") / FileName;
+    const FString TileDirectory = FLandmarkTileManifest::GetTileDirectory(RelativePath);
+    const FDateTime ManifestTime = IFileManager::Get().GetTimeStamp(*FLandmarkTileManifest::GetManifestPath(TileDirectory));
+    if (ManifestTime == FDateTime::MinValue())
+    {
+        return false;
+    }
+
+    // 与 .lmkb 相同：JSON 比瓦片新时整体加载 JSON
+    const FDateTime JsonTime = FMath::Max(IFileManager::Get().GetTimeStamp(*RelativePath), IFileManager::Get().GetTimeStamp(*LandmarkFileFormat::GetJournalPath(RelativePath)));
+    if (JsonTime > ManifestTime)
+    {
+        UE_LOG(LogLandmarkSystem, Warning, TEXT("LandmarkSubsystem: Tiles in %s are older than %s, loading it whole. Run the LandmarkCook commandlet with -TileSize to refresh them."), *TileDirectory, *FileName);
+        return false;
+    }
+
+    TUniquePtr<FLandmarkTileManifest> Manifest = MakeUnique<FLandmarkTileManifest>();
+    if (!Manifest->Read(TileDirectory))
+    {
+        return false;
+    }
+    Out.FileName = FileName;
+    Out.TileManifest = MoveTemp(Manifest);
+    return true;
+}
+
+void ULandmarkSubsystem::StartMapDataLoad(const FString& MapName)
+{
+    LoadingMapName = MapName;
+    LoadState = ELandmarkLoadState::Loading;
+    PendingLoad = MakeShared<FLandmarkLoadResult>();
+
+    const ULandmarkSettings* Settings = ULandmarkSettings::Get();
+    const bool bStreamTiles = Settings && Settings->bStreamLandmarkTiles;
+
+    // 工作线程只读文件、写自己的结果对象；注册在游戏线程的 ticker 里完成
+    LoadTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Result = PendingLoad, MapName, bStreamTiles]()
+    {
+        ReadMapData(MapName, bStreamTiles, *Result);
+    });
+    LoadTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ULandmarkSubsystem::TickMapDataLoad));
+}
+
+bool ULandmarkSubsystem::TickMapDataLoad(float DeltaTime)
+{
+    if (!LoadTask.IsCompleted())
+    {
+        return true;
+    }
+
+    LoadTickerHandle.Reset();
+    FinishMapDataLoad();
+    return false;
+}
+
+void ULandmarkSubsystem::FinishMapDataLoad()
+{
+    LoadTask = UE::Tasks::FTask();
+    const TSharedPtr<FLandmarkLoadResult> Result = MoveTemp(PendingLoad);
+    PendingLoad.Reset();
+
+    bMapDataLoaded = Result.IsValid() && Result->bSuccess;
+    if (bMapDataLoaded)
+    {
+        ApplyLoadResult(*Result, false);
+    }
+    LoadState = ELandmarkLoadState::Loaded;
+    TryCompleteMapDataLoad();
+}
+
+void ULandmarkSubsystem::CancelMapDataLoad()
+{
+    if (LoadTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(LoadTickerHandle);
+        LoadTickerHandle.Reset();
+    }
+    if (LoadTask.IsValid())
+    {
+        LoadTask.Wait();
+        LoadTask = UE::Tasks::FTask();
+    }
+    PendingLoad.Reset();
+    bMapDataLoaded = false;
+    LoadState = ELandmarkLoadState::Idle;
+}
+
+void ULandmarkSubsystem::TryCompleteMapDataLoad()
+{
+    // 城市实体需要 Mass 子系统就绪：数据先到则等 OnWorldBeginPlay，BeginPlay 先到则等数据
+    if (LoadState != ELandmarkLoadState::Loaded || !bWorldBegunPlay)
+    {
+        return;
+    }
+
+    BatchSpawnAllCities();
+    if (GetNumPendingCitySpawns() > 0)
+    {
+        // 分帧生成：队列排空时由 TickCitySpawns（或 FlushPendingCitySpawns）完成
+        LoadState = ELandmarkLoadState::Spawning;
+        return;
+    }
+    CompleteLandmarkLoad();
+}
+
+void ULandmarkSubsystem::CompleteLandmarkLoad()
+{
+    LoadState = bMapDataLoaded ? ELandmarkLoadState::Ready : ELandmarkLoadState::Failed;
+    OnLandmarksLoaded.Broadcast(bMapDataLoaded);
+}
+
+void ULandmarkSubsystem::WaitForLandmarkLoad()
+{
+    if (LoadState != ELandmarkLoadState::Loading)
+    {
+        return;
+    }
+
+    if (LoadTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(LoadTickerHandle);
+        LoadTickerHandle.Reset();
+    }
+    LoadTask.Wait();
+    FinishMapDataLoad();
+}
+
+bool ULandmarkSubsystem::SaveLandmarksToFile(const FString& FileName, const TArray<FLandmarkInstanceData>& DataToSave)
+{
+    FString RelativePath = FPaths::ProjectContentDir() / TEXT("MapData") / FileName;
+
+    // 只把改动追加到 .journal；与 LoadLandmarksFromFile 相同使用地图数据的轴约定
+    return GetSaveJournal(RelativePath).Save(RelativePath, DataToSave, true);
+}
+
+void ULandmarkSubsystem::SaveLandmarksToFileAsync(const FString& FileName, const TArray<FLandmarkInstanceData>& DataToSave, const FOnLandmarkSaveComplete& OnComplete)
+{
+    TSharedRef<FLandmarkSaveRequest> Request = MakeShared<FLandmarkSaveRequest>();
+    Request->FileName = FileName;
+    Request->Records = DataToSave;
+    Request->OnComplete = OnComplete;
+    StartSave(Request);
+}
+
+void ULandmarkSubsystem::SaveRegisteredLandmarksAsync(const FString& FileName, const FOnLandmarkSaveComplete& OnComplete)
+{
+    // 剔除线程只读存储，此时拷贝是安全的；排队中的修改尚未生效，不在快照里
+    TSharedRef<FLandmarkSaveRequest> Request = MakeShared<FLandmarkSaveRequest>();
+    Request->FileName = FileName;
+    Request->StoreSnapshot = MakeUnique<FLandmarkSaveSnapshot>(Landmarks.MakeSaveSnapshot());
+    Request->OnComplete = OnComplete;
+    StartSave(Request);
+}
+
+FLandmarkJournaledFile& ULandmarkSubsystem::GetSaveJournal(const FString& Path)
+{
+    for (const TSharedPtr<FLandmarkSaveRequest>& Pending : PendingSaves)
+    {
+        if (Pending->Path == Path)
+        {
+            Pending->Task.Wait();
+        }
+    }
+
+    TSharedPtr<FLandmarkJournaledFile>& Journal = SaveJournals.FindOrAdd(Path);
+    if (!Journal.IsValid())
+    {
+        Journal = MakeShared<FLandmarkJournaledFile>();
+    }
+    return *Journal;
+}
+
+void ULandmarkSubsystem::StartSave(TSharedRef<FLandmarkSaveRequest> Request)
+{
+    Request->Path = FPaths::ProjectContentDir() / TEXT("MapData") / Request->FileName;
+
+    TSharedPtr<FLandmarkJournaledFile>& Journal = SaveJournals.FindOrAdd(Request->Path);
+    if (!Journal.IsValid())
+    {
+        Journal = MakeShared<FLandmarkJournaledFile>();
+    }
+    Request->Journal = Journal;
+
+    // 同一文件的上一次保存写完之前不能开始（共享同一份日志状态）
+    TArray<UE::Tasks::FTask, TInlineAllocator<1>> Prerequisites;
+    for (const TSharedPtr<FLandmarkSaveRequest>& Pending : PendingSaves)
+    {
+        if (Pending->Path == Request->Path)
+        {
+            Prerequisites.Reset();
+            Prerequisites.Add(Pending->Task);
+        }
+    }
+
+    Request->Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Request]()
+    {
+        if (Request->StoreSnapshot.IsValid())
+        {
+            const FLandmarkSaveSnapshot& Snapshot = *Request->StoreSnapshot;
+            Request->Records.Reserve(Snapshot.Num());
+            for (int32 i = 0; i < Snapshot.Num(); ++i)
+            {
+                Request->Records.Add(Snapshot.MakeInstanceData(i));
+            }
+            Request->StoreSnapshot.Reset();
+        }
+        Request->bSuccess = Request->Journal->Save(Request->Path, Request->Records, true);
+        Request->Records.Empty();
+    }, UE::Tasks::Prerequisites(Prerequisites));
+
+    PendingSaves.Add(Request);
+    if (!SaveTickerHandle.IsValid())
+    {
+        SaveTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ULandmarkSubsystem::TickPendingSaves));
+    }
+}
+
+bool ULandmarkSubsystem::TickPendingSaves(float DeltaTime)
+{
+    CompletePendingSaves(false);
+    if (PendingSaves.Num() > 0)
+    {
+        return true;
+    }
+    SaveTickerHandle.Reset();
+    return false;
+}
+
+void ULandmarkSubsystem::WaitForPendingSaves()
+{
+    if (SaveTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(SaveTickerHandle);
+        SaveTickerHandle.Reset();
+    }
+    CompletePendingSaves(true);
+}
+
+void ULandmarkSubsystem::CompletePendingSaves(bool bWait)
+{
+    int32 NumDone = 0;
+    for (; NumDone < PendingSaves.Num(); ++NumDone)
+    {
+        FLandmarkSaveRequest& Request = *PendingSaves[NumDone];
+        if (bWait)
+        {
+            Request.Task.Wait();
+        }
+        else if (!Request.Task.IsCompleted())
+        {
+            break;
+        }
+    }
+    if (NumDone == 0)
+    {
+        return;
+    }
+
+    // 回调可能再次发起保存，先把已完成的移出队列
+    TArray<TSharedPtr<FLandmarkSaveRequest>> Done(PendingSaves.GetData(), NumDone);
+    PendingSaves.RemoveAt(0, NumDone, EAllowShrinking::No);
+    for (const TSharedPtr<FLandmarkSaveRequest>& Request : Done)
+    {
+        if (!Request->bSuccess)
+        {
+            UE_LOG(LogLandmarkSystem, Error, TEXT("LandmarkSystem: Async save of %s failed"), *Request->Path);
+        }
+        Request->OnComplete.ExecuteIfBound(Request->FileName, Request->bSuccess);
+    }
+}
+
+bool ULandmarkSubsystem::CompactLandmarkFile(const FString& FileName)
+{
+    FString RelativePath = FPaths::ProjectContentDir() / TEXT("MapData") / FileName;
+    GetSaveJournal(RelativePath); // 等同一文件的异步保存写完
+    return FLandmarkJournaledFile::Compact(RelativePath, true);
+}
+
+void ULandmarkSubsystem::RebuildSpatialGrid()
+{
+    SpatialIndex.Reset();
+    bVisibleSetDirty = true;
+
+    Landmarks.ForEachAlive([this](int32 Index)
+    {
+        AddToSpatialGrid(Index);
+    });
+}
+
+void ULandmarkSubsystem::AddToSpatialGrid(int32 Index)
+{
+    bVisibleSetDirty = true;
+    SpatialIndex.Add(Index, Landmarks.GetX()[Index], Landmarks.GetY()[Index], Landmarks.GetZMin()[Index], Landmarks.GetZMax()[Index]);
+}
+
+void ULandmarkSubsystem::RemoveFromSpatialGrid(int32 Index)
+{
+    bVisibleSetDirty = true;
+    SpatialIndex.Remove(Index, Landmarks.GetX()[Index], Landmarks.GetY()[Index], Landmarks.GetZMin()[Index], Landmarks.GetZMax()[Index]);
+}
+
+void ULandmarkSubsystem::UpdateCameraState(const FVector& CameraLocation, const FRotator& CameraRotation, float FOV, float ZoomFactor)
+{
+    // 游戏线程开销计入标签帧预算
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+    ON_SCOPE_EXIT
+    {
+        LabelBudget.AddCost(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+    };
+
+    PollVisibilityUpdate();
+
+    // 上一次剔除仍在工作线程上：不记录本次相机，下一次调用会以最新相机重新发起
+    if (IsVisibilityUpdateInFlight())
+    {
+        return;
+    }
+
+    // 瓦片的注册/卸载只在剔除不在途时进行；有变化时 bVisibleSetDirty 让下面重新剔除
+    UpdateTileStreaming(CameraLocation, CameraRotation, FOV);
+
+    // Optimization: Skip if camera stable (User Request: "Simply cache it!")
+    // If camera hasn't moved significant distance or rotated
+    if (FVector::DistSquared(CameraLocation, LastCameraLoc) < 1.0f && CameraRotation.Equals(LastCameraRot, 0.01f) && FMath::IsNearlyEqual(FOV, LastFOV, 0.01f) && !bVisibleSetDirty)
+    {
+        return; 
+    }
+
+	LastCameraLoc = CameraLocation;
+	LastCameraRot = CameraRotation;
+	LastFOV = FOV;
+	LastZoomFactor = ZoomFactor;
 
-    FIntPoint CenterCell(FMath::FloorToInt(CameraLocation.X / SpatialCellSize), FMath::FloorToInt(CameraLocation.Y / SpatialCellSize));
-    
     // --- Flat UI Layer Strategy (Glass Layer) ---
     // Cache the unified Z once outside the loops to maximize performance.
-    float UnifiedZ = 147.0f;
+    FLandmarkCullRequest Request;
+    Request.CameraLocation = CameraLocation;
+    Request.CameraRotation = CameraRotation;
+    Request.FOV = FOV;
+    Request.AspectRatio = GetViewportAspectRatio();
+
+    float MaxDistance = 0.0f;
+    bool bAsync = true;
     if (const ULandmarkSettings* Settings = ULandmarkSettings::Get())
     {
-        UnifiedZ = Settings->CityLabelZOffset;
+        Request.UnifiedZ = Settings->CityLabelZOffset;
+        MaxDistance = Settings->MaxLabelDistance;
+        bAsync = Settings->bAsyncVisibility;
+        // 截断（MaxVisibleLabels 或预算阶梯的标签上限）必须丢掉优先级最低的标签，同样需要排序
+        Request.bSortByPriority = Settings->bDeclutterLabels || Settings->MaxVisibleLabels > 0
+            || LabelBudget.GetQuality().MaxLabels > 0 || LabelBudget.GetQuality().MinPriority > MIN_int32
+            || FLandmarkBudgetController::GetBudgetMs() > 0.0f;
+    }
+    Request.Serial = ++CullSerial;
+    Request.MaxDistance = MaxDistance > 0.0f ? MaxDistance : FMath::Max(20000.0f, CameraLocation.Z * 4.0f);
+
+    // 预算控制：远处标签降频时，只有每第 N 次更新重新剔除远处部分
+    const int32 FarInterval = LabelBudget.GetQuality().FarRefreshInterval;
+    if (FarInterval > 1)
+    {
+        Request.FarDistance = Request.MaxDistance * FarLabelDistanceRatio;
+        Request.bRefreshFar = (++FarRefreshCounter % FarInterval) == 0;
+    }
+
+    // 以下依赖 UObject 的输入在游戏线程上准备好，工作线程只读快照
+    const int32 Back = 1 - FrontVisibleSet.load(std::memory_order_acquire);
+    ScaleTable.Update(ScaleCurve.GetRichCurveConst(), 1.0f);
+    AlphaTable.Update(AlphaCurve.GetRichCurveConst(), 1.0f);
+
+    // 视图投影矩阵每次更新只构建一次
+    if (!ViewProjection.BuildFromPlayer(UGameplayStatics::GetPlayerController(GetWorld(), 0)))
+    {
+        bVisibleSetDirty = true;
+        VisibleSets[Back].Reset();
+        VisibleSets[Back].Serial = Request.Serial;
+        FrontVisibleSet.store(Back, std::memory_order_release);
+        return;
+    }
+
+    if (!bAsync)
+    {
+        CullVisibleSet(Request, VisibleSets[1 - Back], VisibleSets[Back]);
+        FrontVisibleSet.store(Back, std::memory_order_release);
+        return;
+    }
+
+    // 异步：工作线程写后台缓冲，完成后原子切换前台索引；DrawLandmarks 始终读最近一次完成的结果
+    // 前台缓冲此时只被读取，工作线程可以安全地从中沿用远处标签
+    CullTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, Request, Back]()
+    {
+        const uint64 CullStartCycles = FPlatformTime::Cycles64();
+        CullVisibleSet(Request, VisibleSets[1 - Back], VisibleSets[Back]);
+        CullCycles.fetch_add(FPlatformTime::Cycles64() - CullStartCycles, std::memory_order_relaxed);
+        FrontVisibleSet.store(Back, std::memory_order_release);
+    });
+}
+
+void ULandmarkSubsystem::UpdateTileStreaming(const FVector& CameraLocation, const FRotator& CameraRotation, float FOV)
+{
+    if (!TileStreamer.IsOpen())
+    {
+        return;
     }
 
-    // Iterate neighbor cells
-    for (int32 x = -CellRadius; x <= CellRadius; ++x)
+    // 1. 读完的瓦片落地。键已存在（场景 Actor 等其他来源注册过）的地标不归瓦片所有，卸载时也不动它
+    TileStreamer.CollectLoaded(LoadedTiles);
+    for (const TSharedPtr<FLandmarkTileLoad>& Tile : LoadedTiles)
     {
-        for (int32 y = -CellRadius; y <= CellRadius; ++y)
+        TArray<FLandmarkHandle> Handles;
+        Handles.Reserve(Tile->Records.Num());
+        for (int32 i = 0; i < Tile->Records.Num(); ++i)
         {
-            FIntPoint TargetCell = CenterCell + FIntPoint(x, y);
-            if (TArray<FString>* ListPtr = SpatialGrid.Find(TargetCell))
+            if (Landmarks.FindByKey(Tile->Keys[i]).IsSet()) continue;
+
+            FLandmarkInstanceData& Data = Tile->Records[i];
+            if (Data.Value == 0)
             {
-                // Iterate Landmarks in this cell
-                for (const FString& ID : *ListPtr)
-                {
-                    FLandmarkInstanceData* DataPtr = RegisteredLandmarks.Find(ID);
-                    if (!DataPtr) continue;
-                    
-                    const FLandmarkInstanceData& Data = *DataPtr;
-
-                    // 0. Height Filtering
-                    float CamZ = CameraLocation.Z;
-                    if (CamZ < Data.ZMin || CamZ > Data.ZMax)
-                    {
-                        continue;
-                    }
+                Data.Value = GetDefaultVictoryPoints(Data.Type);
+            }
+            const FLandmarkHandle Handle = Landmarks.Add(Tile->Keys[i], Data);
+            AddToSpatialGrid(Handle.Index);
+            Handles.Add(Handle);
+        }
+        TileStreamer.SetResident(Tile->Tile, MoveTemp(Handles));
+    }
+    LoadedTiles.Reset();
+
+    // 2. 常驻范围：与剔除相同的视锥地面足迹；看不到标签平面时保留相机正下方
+    const ULandmarkSettings* Settings = ULandmarkSettings::Get();
+    const float PlaneZ = Settings ? Settings->CityLabelZOffset : 0.0f;
+    const float MaxLabelDistance = Settings ? Settings->MaxLabelDistance : 0.0f;
+    const float MaxDistance = MaxLabelDistance > 0.0f ? MaxLabelDistance : FMath::Max(20000.0f, (float)CameraLocation.Z * 4.0f);
+
+    const FVector2D Focus(CameraLocation.X, CameraLocation.Y);
+    FBox2D Required(Focus, Focus);
+    if (StreamingFootprint.Build(CameraLocation, CameraRotation, FOV, GetViewportAspectRatio(), PlaneZ, MaxDistance))
+    {
+        Required = StreamingFootprint.Bounds;
+    }
+
+    const float Radius = Settings ? Settings->TileResidencyRadius : 0.0f;
+    const int64 BudgetBytes = Settings ? (int64)Settings->TileMemoryBudgetMB * 1024 * 1024 : 0;
+    TileStreamer.Update(Required, Focus, Radius, BudgetBytes, EvictedLandmarks);
+
+    // 3. 卸载：句柄已失效（被单独注销、槽位已复用）的跳过
+    for (const FLandmarkHandle& Handle : EvictedLandmarks)
+    {
+        if (Landmarks.IsValid(Handle))
+        {
+            RemoveFromSpatialGrid(Handle.Index);
+            Landmarks.Remove(Handle);
+        }
+    }
+    EvictedLandmarks.Reset();
+}
+
+void ULandmarkSubsystem::CullVisibleSet(const FLandmarkCullRequest& Request, const FLandmarkVisibleSet& Previous, FLandmarkVisibleSet& Out)
+{
+    Out.Reset();
+    Out.Serial = Request.Serial;
+
+    const FVector& CameraLocation = Request.CameraLocation;
+    const FRotator& CameraRotation = Request.CameraRotation;
+    const float FOV = Request.FOV;
+    const float AspectRatio = Request.AspectRatio;
+    const float UnifiedZ = Request.UnifiedZ;
 
-                    FVector FinalLocation(Data.X, Data.Y, UnifiedZ);
+	// Calculate Visible Cell Range
+    // 视锥与标签平面求交得到凸多边形，只枚举落在其中的格子（真实 FOV 与视口宽高比）
+    if (!ViewFootprint.Build(CameraLocation, CameraRotation, FOV, AspectRatio, UnifiedZ, Request.MaxDistance))
+    {
+        bVisibleSetDirty = true;
+        return; // 视锥够不到标签平面（例如仰视）
+    }
 
-                    // 2. Project
-                    FVector2D ScreenPos;
-                    if (ProjectWorldLocationToScreen(FinalLocation, ScreenPos))
+    // 按相机高度选金字塔层：格子边长与高度同比增长，覆盖的格子数近似为常数，无需裁剪半径
+    const int32 Level = SpatialIndex.SelectLevel(CameraLocation.Z);
+    Swap(FootprintSpans, PreviousSpans);
+    ViewFootprint.GetCellSpans(SpatialIndex.GetCellSize(Level), FootprintSpans);
+
+    // 1. 维护候选格子集合
+    // 平移（高度、朝向、FOV、层级不变）时足迹只是整体平移：只处理进入/离开的边缘格子。
+    // 缩放、旋转或数据变化时整体重建。
+    const bool bIncremental = !bVisibleSetDirty
+        && Level == ActiveLevel
+        && CameraLocation.Z == ActiveFilterZ
+        && CameraRotation.Equals(ActiveRotation, 0.0f)
+        && FOV == ActiveFOV
+        && AspectRatio == ActiveAspectRatio;
+
+    if (bIncremental)
+    {
+        ForEachCellNotIn(PreviousSpans, FootprintSpans, [this](const FIntPoint& Cell)
+        {
+            ActiveCells.Remove(Cell);
+        });
+        ForEachCellNotIn(FootprintSpans, PreviousSpans, [this, Level](const FIntPoint& Cell)
+        {
+            const FLandmarkSpatialCell* Members = SpatialIndex.FindCell(Level, Cell);
+            if (Members && Members->IsAnyVisibleAt(ActiveFilterZ))
+            {
+                AddActiveCell(Cell, *Members);
+            }
+        });
+    }
+    else
+    {
+        ActiveCells.Reset();
+        ActiveLevel = Level;
+        ActiveFilterZ = CameraLocation.Z;
+        ActiveRotation = CameraRotation;
+        ActiveFOV = FOV;
+        ActiveAspectRatio = AspectRatio;
+        bVisibleSetDirty = false;
+
+        int64 SpanCells = 0;
+        for (const FLandmarkCellSpan& Span : FootprintSpans)
+        {
+            SpanCells += Span.Num();
+        }
+
+        if (SpanCells >= ParallelRebuildMinCells && SpanCells <= SpatialIndex.NumOccupiedCells(Level))
+        {
+            // 足迹行之间互不依赖：每行在工作线程上过滤到自己的缓冲，再按行序写入 ActiveCells
+            RebuildRows.SetNum(FootprintSpans.Num());
+            ParallelFor(TEXT("LandmarkCullRebuild"), FootprintSpans.Num(), 1, [this, Level](int32 Row)
+            {
+                const FLandmarkCellSpan& Span = FootprintSpans[Row];
+                TArray<TPair<FIntPoint, TArray<int32>>>& Out = RebuildRows[Row];
+                Out.Reset();
+                for (int32 CellX = Span.MinX; CellX <= Span.MaxX; ++CellX)
+                {
+                    const FIntPoint Cell(CellX, Span.Y);
+                    const FLandmarkSpatialCell* Members = SpatialIndex.FindCell(Level, Cell);
+                    if (!Members || !Members->IsAnyVisibleAt(ActiveFilterZ)) continue;
+
+                    TPair<FIntPoint, TArray<int32>>& Entry = Out.Emplace_GetRef(Cell, TArray<int32>());
+                    Members->GetVisibleAt(ActiveFilterZ, Entry.Value);
+                    if (Entry.Value.Num() == 0)
                     {
-                        VisibleLandmarkIDs.Add(ID);
-                        CachedScreenPositions.Add(ScreenPos);
-
-                        // --- Dynamic Scaling ---
-                        // Evaluate scale based on distance using curve
-                        float ScaleFactor = 1.0f;
-                        if (ScaleCurve.GetRichCurve() && !ScaleCurve.GetRichCurve()->IsEmpty())
-                        {
-                            float Distance = FVector::Dist(CameraLocation, FinalLocation);
-                            ScaleFactor = ScaleCurve.GetRichCurve()->Eval(Distance);
-                        }
-                        CachedScales.Add(ScaleFactor);
-
-                        // --- Alpha Fading ---
-                        float AlphaFactor = 1.0f;
-                        if (AlphaCurve.GetRichCurve() && !AlphaCurve.GetRichCurve()->IsEmpty())
-                        {
-                            float Distance = FVector::Dist(CameraLocation, FinalLocation);
-                            AlphaFactor = AlphaCurve.GetRichCurve()->Eval(Distance);
-                        }
-                        CachedAlphas.Add(AlphaFactor);
+                        Out.Pop(EAllowShrinking::No);
                     }
                 }
+            });
+
+            for (TArray<TPair<FIntPoint, TArray<int32>>>& Row : RebuildRows)
+            {
+                for (TPair<FIntPoint, TArray<int32>>& Entry : Row)
+                {
+                    ActiveCells.Add(Entry.Key, MoveTemp(Entry.Value));
+                }
+                Row.Reset();
+            }
+        }
+        else
+        {
+            SpatialIndex.ForEachCellInSpans(Level, FootprintSpans, ActiveFilterZ, [this](const FIntPoint& Cell, const FLandmarkSpatialCell& Members)
+            {
+                AddActiveCell(Cell, Members);
+            });
+        }
+    }
+
+    // 热数组：剔除循环只读这些连续数组
+    const TArray<double>& PosX = Landmarks.GetX();
+    const TArray<double>& PosY = Landmarks.GetY();
+
+    // Gather: 候选坐标转为相对视点的连续 float 数组，整批重新投影
+    CandidateSlots.Reset();
+    CandidateRelX.Reset();
+    CandidateRelY.Reset();
+    const double OriginX = ViewProjection.ViewOrigin.X;
+    const double OriginY = ViewProjection.ViewOrigin.Y;
+    const float RelZ = (float)(UnifiedZ - ViewProjection.ViewOrigin.Z);
+
+    // 远处标签降频：平移时只有上一次可见的远处候选参与剔除（照常重新投影、计算缩放与透明度），
+    // 其余远处候选等到每第 N 次更新才重新检查，即新出现的远处标签最多晚 N-1 次更新显示。
+    // 每个槽位只经过一次候选收集，不会重复输出；判断远近用的是当前距离。
+    const bool bReuseFar = bIncremental && Request.FarDistance > 0.0f && !Request.bRefreshFar;
+    const float FarDistanceSq = bReuseFar ? FMath::Square(Request.FarDistance) : TNumericLimits<float>::Max();
+    if (bReuseFar)
+    {
+        PreviousVisibleSlots.Init(false, Landmarks.NumSlots());
+        for (const FLandmarkHandle& Handle : Previous.Handles)
+        {
+            if (Landmarks.IsValid(Handle))
+            {
+                PreviousVisibleSlots[Handle.Index] = true;
+            }
+        }
+    }
+
+    for (const TPair<FIntPoint, TArray<int32>>& Pair : ActiveCells)
+    {
+        for (const int32 Index : Pair.Value)
+        {
+            const float RelX = (float)(PosX[Index] - OriginX);
+            const float RelY = (float)(PosY[Index] - OriginY);
+            if (RelX * RelX + RelY * RelY + RelZ * RelZ > FarDistanceSq && !PreviousVisibleSlots[Index]) continue;
+
+            CandidateSlots.Add(Index);
+            CandidateRelX.Add(RelX);
+            CandidateRelY.Add(RelY);
+        }
+    }
+
+    // 2. Project + Scale/Alpha: 候选按固定大小分块，各块独立写入自己的缓冲，再按块序合并。
+    // 分块与线程数无关，结果完全确定；候选少时在游戏线程上顺序执行。
+    FLandmarkCullInput CullInput;
+    CullInput.Projection = &ViewProjection;
+    CullInput.ScaleTable = &ScaleTable;
+    CullInput.AlphaTable = &AlphaTable;
+    CullInput.Slots = CandidateSlots.GetData();
+    CullInput.RelX = CandidateRelX.GetData();
+    CullInput.RelY = CandidateRelY.GetData();
+    CullInput.RelZ = RelZ;
+    CullInput.ScreenMargin = LabelScreenMargin;
+    CullInput.MinAlpha = MinLabelAlpha;
+
+    const int32 NumCandidates = CandidateSlots.Num();
+    const int32 NumChunks = FMath::DivideAndRoundUp(NumCandidates, CullChunkSize);
+    if (CullChunks.Num() < NumChunks)
+    {
+        CullChunks.SetNum(NumChunks);
+    }
+
+    ParallelFor(TEXT("LandmarkCull"), NumChunks, 1, [this, &CullInput, NumCandidates](int32 Chunk)
+    {
+        const int32 Begin = Chunk * CullChunkSize;
+        const int32 End = FMath::Min(Begin + CullChunkSize, NumCandidates);
+        CullCandidateRange(CullInput, Begin, End, CullChunks[Chunk]);
+    }, NumCandidates < ParallelCullMinCandidates ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+    // 3. Merge in chunk order
+    int32 NumVisible = 0;
+    for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+    {
+        NumVisible += CullChunks[Chunk].Num();
+    }
+    Out.Handles.Reserve(NumVisible);
+    Out.ScreenPositions.Reserve(NumVisible);
+    Out.Scales.Reserve(NumVisible);
+    Out.Alphas.Reserve(NumVisible);
+    Out.Distances.Reserve(NumVisible);
+
+    for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+    {
+        const FLandmarkCullChunk& Result = CullChunks[Chunk];
+        for (int32 i = 0; i < Result.Num(); ++i)
+        {
+            Out.Handles.Add(Landmarks.GetHandle(Result.Slots[i]));
+            Out.ScreenPositions.Add(FVector2D(Result.ScreenX[i], Result.ScreenY[i]));
+        }
+        Out.Scales.Append(Result.Scales);
+        Out.Alphas.Append(Result.Alphas);
+        Out.Distances.Append(Result.Distances);
+    }
+
+    // 4. 去重叠的放置顺序：优先级高的先放，其次按类型、距离；槽位号兜底保证顺序确定
+    if (Request.bSortByPriority && NumVisible > 1)
+    {
+        const TArray<int32>& Priorities = Landmarks.GetPriorities();
+        const TArray<int32>& TypeIds = Landmarks.GetTypeIds();
+
+        SortScratch.SetNumUninitialized(NumVisible, EAllowShrinking::No);
+        for (int32 i = 0; i < NumVisible; ++i)
+        {
+            SortScratch[i] = i;
+        }
+        Algo::Sort(SortScratch, [&Out, &Priorities, &TypeIds](int32 A, int32 B)
+        {
+            const int32 SlotA = Out.Handles[A].Index;
+            const int32 SlotB = Out.Handles[B].Index;
+            if (Priorities[SlotA] != Priorities[SlotB]) return Priorities[SlotA] > Priorities[SlotB];
+            if (TypeIds[SlotA] != TypeIds[SlotB]) return TypeIds[SlotA] < TypeIds[SlotB];
+            if (Out.Distances[A] != Out.Distances[B]) return Out.Distances[A] < Out.Distances[B];
+            return SlotA < SlotB;
+        });
+
+        SortBuffer.Reset();
+        for (const int32 i : SortScratch)
+        {
+            SortBuffer.Handles.Add(Out.Handles[i]);
+            SortBuffer.ScreenPositions.Add(Out.ScreenPositions[i]);
+            SortBuffer.Scales.Add(Out.Scales[i]);
+            SortBuffer.Alphas.Add(Out.Alphas[i]);
+            SortBuffer.Distances.Add(Out.Distances[i]);
+        }
+        Swap(Out.Handles, SortBuffer.Handles);
+        Swap(Out.ScreenPositions, SortBuffer.ScreenPositions);
+        Swap(Out.Scales, SortBuffer.Scales);
+        Swap(Out.Alphas, SortBuffer.Alphas);
+        Swap(Out.Distances, SortBuffer.Distances);
+    }
+}
+
+void ULandmarkSubsystem::PollVisibilityUpdate()
+{
+    if (CullTask.IsValid() && CullTask.IsCompleted())
+    {
+        CullTask = UE::Tasks::FTask();
+        LabelBudget.AddCost(FPlatformTime::ToMilliseconds64(CullCycles.exchange(0, std::memory_order_relaxed)));
+    }
+
+    // 剔除期间排队的注册/注销在这里落地，并令下一次剔除整体重建
+    if (!CullTask.IsValid() && PendingMutations.Num() > 0)
+    {
+        TArray<FLandmarkPendingMutation> Mutations = MoveTemp(PendingMutations);
+        PendingMutations.Reset();
+        for (FLandmarkPendingMutation& Mutation : Mutations)
+        {
+            switch (Mutation.Type)
+            {
+            case ELandmarkMutation::Register:      RegisterLandmark(Mutation.Data); break;
+            case ELandmarkMutation::Update:        UpdateLandmark(Mutation.ID, Mutation.Data); break;
+            case ELandmarkMutation::Unregister:    UnregisterLandmark(Mutation.ID); break;
+            case ELandmarkMutation::UnregisterAll: UnregisterAll(); break;
             }
         }
     }
 }
 
-void ULandmarkSubsystem::GetVisibleLandmarks(TArray<FLandmarkInstanceData>& OutVisibleLandmarks, TArray<FVector2D>& OutScreenPositions, TArray<float>& OutScales, TArray<float>& OutAlphas)
+bool ULandmarkSubsystem::IsVisibilityUpdateInFlight() const
 {
-	OutVisibleLandmarks.Reset();
-	OutScreenPositions = CachedScreenPositions;
-	OutScales = CachedScales;
-	OutAlphas = CachedAlphas;
+    return CullTask.IsValid() && !CullTask.IsCompleted();
+}
 
-	for (const FString& ID : VisibleLandmarkIDs)
+void ULandmarkSubsystem::WaitForVisibilityUpdate()
+{
+    if (CullTask.IsValid())
+    {
+        CullTask.Wait();
+    }
+    PollVisibilityUpdate();
+}
+
+void ULandmarkSubsystem::GetVisibleLandmarks(TArray<FLandmarkInstanceData>& OutVisibleLandmarks, TArray<FVector2D>& OutScreenPositions, TArray<float>& OutScales, TArray<float>& OutAlphas)
+{
+	PollVisibilityUpdate();
+	const FLandmarkVisibleSet& Visible = GetFrontVisibleSet();
+
+	// Reset + Append 保留调用方数组的容量，多次轮询不重新分配
+	OutScreenPositions.Reset();
+	OutScreenPositions.Append(Visible.ScreenPositions);
+	OutScales.Reset();
+	OutScales.Append(Visible.Scales);
+	OutAlphas.Reset();
+	OutAlphas.Append(Visible.Alphas);
+
+	// 逐元素赋值复用已有 FString 的缓冲
+	OutVisibleLandmarks.SetNum(Visible.Num(), EAllowShrinking::No);
+	for (int32 i = 0; i < Visible.Num(); ++i)
 	{
-		if (FLandmarkInstanceData* Ptr = RegisteredLandmarks.Find(ID))
+		const FLandmarkHandle& Handle = Visible.Handles[i];
+		if (Landmarks.IsValid(Handle))
 		{
-			OutVisibleLandmarks.Add(*Ptr);
+			OutVisibleLandmarks[i] = Landmarks.MakeInstanceData(Handle.Index);
 		}
 		else
 		{
 			// Should not happen, but keep arrays synced
-			OutVisibleLandmarks.Add(FLandmarkInstanceData()); 
+			OutVisibleLandmarks[i] = FLandmarkInstanceData();
 		}
 	}
 }
 
+FLandmarkVisibleView ULandmarkSubsystem::GetVisibleView()
+{
+	PollVisibilityUpdate();
+	const FLandmarkVisibleSet& Visible = GetFrontVisibleSet();
+
+	FLandmarkVisibleView View;
+	View.Handles = Visible.Handles;
+	View.ScreenPositions = Visible.ScreenPositions;
+	View.Scales = Visible.Scales;
+	View.Alphas = Visible.Alphas;
+	return View;
+}
+
+const FLandmarkColdData* ULandmarkSubsystem::FindLandmarkRecord(FLandmarkHandle Handle) const
+{
+	return Landmarks.IsValid(Handle) ? &Landmarks.GetCold(Handle.Index) : nullptr;
+}
+
+void ULandmarkSubsystem::GetVisibleLandmarkHandles(TArray<FLandmarkHandle>& OutHandles, TArray<FVector2D>& OutScreenPositions, TArray<float>& OutScales, TArray<float>& OutAlphas)
+{
+	const FLandmarkVisibleView View = GetVisibleView();
+
+	OutHandles.Reset();
+	OutHandles.Append(View.Handles);
+	OutScreenPositions.Reset();
+	OutScreenPositions.Append(View.ScreenPositions);
+	OutScales.Reset();
+	OutScales.Append(View.Scales);
+	OutAlphas.Reset();
+	OutAlphas.Append(View.Alphas);
+}
+
+FString ULandmarkSubsystem::GetLandmarkName(FLandmarkHandle Handle) const
+{
+	const FLandmarkColdData* Record = FindLandmarkRecord(Handle);
+	return Record ? Record->Name : FString();
+}
+
+int32 ULandmarkSubsystem::GetLandmarkValue(FLandmarkHandle Handle) const
+{
+	return Landmarks.IsValid(Handle) ? Landmarks.GetValues()[Handle.Index] : 0;
+}
+
 // SpawnMissingCities removed (inlined in OnWorldBeginPlay)
 
-void ULandmarkSubsystem::DrawLandmarks(UCanvas* InCanvas)
+const FLandmarkDrawRecord& ULandmarkSubsystem::GetDrawRecord(UCanvas* Canvas, int32 Index, const UFont* UseNameFont, const UFont* UseVPFont, float VisualScale)
 {
-    if (!InCanvas) return;
+    if (DrawRecords.Num() < Landmarks.NumSlots())
+    {
+        DrawRecords.SetNum(Landmarks.NumSlots());
+    }
+    FLandmarkDrawRecord& Record = DrawRecords[Index];
 
-    // Use cached data directly
-    for (int32 i = 0; i < VisibleLandmarkIDs.Num(); ++i)
+    // --- 文本与测量：只在地标、字体或语言变化时 ---
+    const FLandmarkHandle Handle = Landmarks.GetHandle(Index);
+    const uint32 Revision = Landmarks.GetRevision(Index);
+    if (Record.Generation != Handle.Generation || Record.Revision != Revision || Record.CultureRevision != CultureRevision
+        || Record.NameFont != UseNameFont || Record.VPFont != UseVPFont)
     {
-        if (!CachedScreenPositions.IsValidIndex(i)) continue;
+        Record.Generation = Handle.Generation;
+        Record.Revision = Revision;
+        Record.CultureRevision = CultureRevision;
+        Record.NameFont = UseNameFont;
+        Record.VPFont = UseVPFont;
+
+        const FString& Name = Landmarks.GetCold(Index).Name;
+        Record.NameText = FText::FromString(Name);
+        float XL, YL;
+        Canvas->StrLen(UseNameFont, Name, XL, YL);
+        Record.NameSize = FVector2f(XL, YL);
+
+        const int32 Value = Landmarks.GetValues()[Index];
+        Record.bHasVP = (Value > 0);
+        Record.VPText = FText::GetEmpty();
+        Record.VPSize = FVector2f::ZeroVector;
+        if (Record.bHasVP)
+        {
+            const FString VPString = FString::Printf(TEXT("%d 胜利点"), Value);
+            Record.VPText = FText::FromString(VPString);
+            Canvas->StrLen(UseVPFont, VPString, XL, YL);
+            Record.VPSize = FVector2f(XL, YL);
+        }
 
-        FString ID = VisibleLandmarkIDs[i];
-        FLandmarkInstanceData* DataPtr = RegisteredLandmarks.Find(ID);
-        if (!DataPtr) continue;
+        Record.ScaleBucket = INDEX_NONE;
+    }
 
-        const FLandmarkInstanceData& Data = *DataPtr;
-        const FVector2D& ScreenPos = CachedScreenPositions[i];
-        
-        // --- Scale Calculation ---
-        float OriginalScale = CachedScales[i];
-        float SettingsBaseScale = 1.0f;
-        if (const ULandmarkSettings* Settings = ULandmarkSettings::Get())
+    // --- 布局：只在缩放档位变化时 ---
+    const int32 Bucket = FMath::Max(FMath::RoundToInt(VisualScale * DrawScaleBucketsPerUnit), 1);
+    if (Record.ScaleBucket != Bucket)
+    {
+        Record.ScaleBucket = Bucket;
+        Record.Scale = (float)Bucket / DrawScaleBucketsPerUnit;
+
+        const FVector2f NameSizeScaled = Record.NameSize * Record.Scale;
+        const FVector2f VPSizeScaled = Record.bHasVP ? Record.VPSize * (Record.Scale * 0.8f) : FVector2f::ZeroVector;
+
+        // Anchor is ScreenPos (The Roof). We stack upwards: [Roof] <- [VP] <- [Name]
+        Record.VPOffset = FVector2f(-VPSizeScaled.X * 0.5f, -VPSizeScaled.Y);
+        Record.NameOffset = FVector2f(-NameSizeScaled.X * 0.5f, -VPSizeScaled.Y - NameSizeScaled.Y);
+        Record.StackSize = FVector2f(FMath::Max(NameSizeScaled.X, VPSizeScaled.X), NameSizeScaled.Y + VPSizeScaled.Y);
+        Record.NameOnlyOffset = FVector2f(-NameSizeScaled.X * 0.5f, -NameSizeScaled.Y);
+        Record.NameOnlySize = NameSizeScaled;
+    }
+
+    return Record;
+}
+
+void ULandmarkSubsystem::DeclutterVisibleSet(UCanvas* Canvas, const FLandmarkVisibleSet& Visible, const FLandmarkDrawOrderKey& Key)
+{
+    DrawOrder.Reset();
+    const int32 Limit = Key.MaxLabels > 0 ? FMath::Min(Key.MaxLabels, Visible.Num()) : Visible.Num();
+
+    if (!Key.bDeclutter)
+    {
+        for (int32 i = 0; i < Visible.Num() && DrawOrder.Num() < Limit; ++i)
+        {
+            const FLandmarkHandle Handle = Visible.Handles[i];
+            if (Landmarks.IsValid(Handle) && Landmarks.GetPriorities()[Handle.Index] >= Key.MinPriority)
+            {
+                DrawOrder.Add(i);
+            }
+        }
+        return;
+    }
+
+    const int32 CellSize = FMath::Max(Key.CellSize, 1);
+    const int32 GridW = FMath::Max(FMath::DivideAndRoundUp(Key.CanvasSize.X, CellSize), 1);
+    const int32 GridH = FMath::Max(FMath::DivideAndRoundUp(Key.CanvasSize.Y, CellSize), 1);
+    OccupancyGrid.Init(false, GridW * GridH);
+
+    // Visible 已按 优先级 -> 类型 -> 距离 排好序：先放下的标签占住位置
+    for (int32 i = 0; i < Visible.Num() && DrawOrder.Num() < Limit; ++i)
+    {
+        const FLandmarkHandle Handle = Visible.Handles[i];
+        if (!Landmarks.IsValid(Handle)) continue;
+        if (Landmarks.GetPriorities()[Handle.Index] < Key.MinPriority) continue;
+
+        const FLandmarkDrawRecord& Record = GetDrawRecord(Canvas, Handle.Index, Key.NameFont, Key.VPFont, Visible.Scales[i] * Key.BaseScale);
+        const FVector2D& ScreenPos = Visible.ScreenPositions[i];
+
+        // 标签堆叠的屏幕矩形（锚点在底边中点）
+        const FVector2f Size = Key.bShowVP ? Record.StackSize : Record.NameOnlySize;
+        const float MinX = ScreenPos.X - Size.X * 0.5f;
+        const float MaxX = ScreenPos.X + Size.X * 0.5f;
+        const float MinY = ScreenPos.Y - Size.Y;
+        const float MaxY = ScreenPos.Y;
+        if (MaxX < 0.0f || MaxY < 0.0f || MinX >= Key.CanvasSize.X || MinY >= Key.CanvasSize.Y) continue;
+
+        const int32 X0 = FMath::Clamp(FMath::FloorToInt(MinX / CellSize), 0, GridW - 1);
+        const int32 X1 = FMath::Clamp(FMath::FloorToInt(MaxX / CellSize), 0, GridW - 1);
+        const int32 Y0 = FMath::Clamp(FMath::FloorToInt(MinY / CellSize), 0, GridH - 1);
+        const int32 Y1 = FMath::Clamp(FMath::FloorToInt(MaxY / CellSize), 0, GridH - 1);
+
+        bool bFree = true;
+        for (int32 Y = Y0; Y <= Y1 && bFree; ++Y)
         {
-            SettingsBaseScale = Settings->BaseFontScale;
+            for (int32 X = X0; X <= X1; ++X)
+            {
+                if (OccupancyGrid[Y * GridW + X])
+                {
+                    bFree = false;
+                    break;
+                }
+            }
         }
+        if (!bFree) continue;
 
-        // Apply base scale from settings + dynamic scale from curve
-        float VisualScale = OriginalScale * SettingsBaseScale; 
-        float Alpha = CachedAlphas[i];
-        
-        if (Alpha <= 0.01f) continue;
+        for (int32 Y = Y0; Y <= Y1; ++Y)
+        {
+            OccupancyGrid.SetRange(Y * GridW + X0, X1 - X0 + 1, true);
+        }
+        DrawOrder.Add(i);
+    }
+}
 
-        // resolve Fonts
-        UFont* UseNameFont = NameFont ? NameFont.Get() : GEngine->GetLargeFont();
-        UFont* UseVPFontTarget = VPFont ? VPFont.Get() : UseNameFont; // Default to NameFont if VPFont missing
+void ULandmarkSubsystem::DrawLandmarks(UCanvas* InCanvas)
+{
+    if (!InCanvas) return;
+
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    PollVisibilityUpdate();
+    const FLandmarkVisibleSet& Visible = GetFrontVisibleSet();
+
+    // 每帧只读一次设置、解析一次字体
+    float SettingsBaseScale = 1.0f;
+    if (const ULandmarkSettings* Settings = ULandmarkSettings::Get())
+    {
+        SettingsBaseScale = Settings->BaseFontScale;
+    }
+    UFont* UseNameFont = NameFont ? NameFont.Get() : GEngine->GetLargeFont();
+    UFont* UseVPFontTarget = VPFont ? VPFont.Get() : UseNameFont; // Default to NameFont if VPFont missing
+
+    // 去重叠：只在可见集、字体、缩放、画布尺寸或设置变化时重新计算
+    FLandmarkDrawOrderKey Key;
+    Key.Serial = Visible.Serial;
+    Key.NameFont = UseNameFont;
+    Key.VPFont = UseVPFontTarget;
+    Key.BaseScale = SettingsBaseScale;
+    Key.CanvasSize = FIntPoint(FMath::RoundToInt(InCanvas->ClipX), FMath::RoundToInt(InCanvas->ClipY));
+    if (const ULandmarkSettings* Settings = ULandmarkSettings::Get())
+    {
+        Key.bDeclutter = Settings->bDeclutterLabels;
+        Key.CellSize = Settings->DeclutterCellSize;
+        Key.MaxLabels = Settings->MaxVisibleLabels;
+    }
+
+    // 预算控制器的质量档位
+    const FLandmarkLabelQuality& Quality = LabelBudget.GetQuality();
+    if (Quality.MaxLabels > 0)
+    {
+        Key.MaxLabels = Key.MaxLabels > 0 ? FMath::Min(Key.MaxLabels, Quality.MaxLabels) : Quality.MaxLabels;
+    }
+    Key.MinPriority = Quality.MinPriority;
+    Key.bShowVP = Quality.bShowVP;
+    if (Key != DrawOrderKey)
+    {
+        DeclutterVisibleSet(InCanvas, Visible, Key);
+        DrawOrderKey = Key;
+    }
+
+    // Use cached data directly
+    for (const int32 i : DrawOrder)
+    {
+        const FLandmarkHandle Handle = Visible.Handles[i];
+        if (!Landmarks.IsValid(Handle)) continue;
+
+        float Alpha = Visible.Alphas[i];
+
+        // Apply base scale from settings + dynamic scale from curve
+        const float VisualScale = Visible.Scales[i] * SettingsBaseScale;
+        const FLandmarkDrawRecord& Record = GetDrawRecord(InCanvas, Handle.Index, UseNameFont, UseVPFontTarget, VisualScale);
+        const FVector2D& ScreenPos = Visible.ScreenPositions[i];
 
-        // --- 1. Measure Name ---
-        FCanvasTextItem NameItem(FVector2D::ZeroVector, FText::FromString(Data.Name), UseNameFont, FLinearColor(1.0f, 1.0f, 1.0f, Alpha));
-        NameItem.Scale = FVector2D(VisualScale, VisualScale);
-        NameItem.EnableShadow(FLinearColor::Black);
-        
-        float NXL, NYL;
-        InCanvas->StrLen(UseNameFont, Data.Name, NXL, NYL);
-        NameItem.DrawnSize = FVector2D(NXL, NYL);
-        FVector2D NameSizeScaled = NameItem.DrawnSize * NameItem.Scale;
-
-        // --- 2. Measure VP (if any) ---
-        bool bHasVP = (Data.Value > 0);
-        FCanvasTextItem VPItem(FVector2D::ZeroVector, FText::GetEmpty(), UseVPFontTarget, FLinearColor(1.0f, 0.84f, 0.0f, Alpha));
-        FVector2D VPSizeScaled = FVector2D::ZeroVector;
-
-        if (bHasVP)
-        {
-             FString VPString = FString::Printf(TEXT("%d 胜利点"), Data.Value);
-             VPItem.Text = FText::FromString(VPString);
-             VPItem.Scale = FVector2D(VisualScale * 0.8f, VisualScale * 0.8f);
-             VPItem.EnableShadow(FLinearColor::Black);
-             
-             float VXL, VYL;
-             InCanvas->StrLen(UseVPFontTarget, VPString, VXL, VYL);
-             VPItem.DrawnSize = FVector2D(VXL, VYL);
-             VPSizeScaled = VPItem.DrawnSize * VPItem.Scale;
-        }
-
-        // --- 3. Layout Stack (Bottom-Up Anchor) ---
-        // Anchor is ScreenPos (The Roof). We stack upwards: [Roof] <- [VP] <- [Name]
-        float CurrentY = ScreenPos.Y;
-        
         // Stack VP first (Bottom element)
-        if (bHasVP)
+        const bool bDrawVP = Record.bHasVP && Key.bShowVP;
+        if (bDrawVP)
         {
-            CurrentY -= VPSizeScaled.Y;
-            FVector2D VPPos(ScreenPos.X - (VPSizeScaled.X * 0.5f), CurrentY);
-            
+            FCanvasTextItem VPItem(FVector2D::ZeroVector, Record.VPText, UseVPFontTarget, FLinearColor(1.0f, 0.84f, 0.0f, Alpha));
+            VPItem.Scale = FVector2D(Record.Scale * 0.8f, Record.Scale * 0.8f);
+            VPItem.EnableShadow(FLinearColor::Black);
+
             // Pixel Snap
-            VPPos.X = FMath::RoundToFloat(VPPos.X);
-            VPPos.Y = FMath::RoundToFloat(VPPos.Y);
-            
-            VPItem.Position = VPPos;
+            VPItem.Position = FVector2D(FMath::RoundToFloat(ScreenPos.X + Record.VPOffset.X), FMath::RoundToFloat(ScreenPos.Y + Record.VPOffset.Y));
             InCanvas->DrawItem(VPItem);
         }
 
         // Stack Name second (Top element)
-        CurrentY -= NameSizeScaled.Y;
-        FVector2D NamePos(ScreenPos.X - (NameSizeScaled.X * 0.5f), CurrentY);
-        
+        FCanvasTextItem NameItem(FVector2D::ZeroVector, Record.NameText, UseNameFont, FLinearColor(1.0f, 1.0f, 1.0f, Alpha));
+        NameItem.Scale = FVector2D(Record.Scale, Record.Scale);
+        NameItem.EnableShadow(FLinearColor::Black);
+
         // Pixel Snap
-        NamePos.X = FMath::RoundToFloat(NamePos.X);
-        NamePos.Y = FMath::RoundToFloat(NamePos.Y);
-        
-        NameItem.Position = NamePos;
+        const FVector2f& NameOffset = Key.bShowVP ? Record.NameOffset : Record.NameOnlyOffset;
+        NameItem.Position = FVector2D(FMath::RoundToFloat(ScreenPos.X + NameOffset.X), FMath::RoundToFloat(ScreenPos.Y + NameOffset.Y));
         InCanvas->DrawItem(NameItem);
         
     } // End Loop
+
+    // 一次 HUD 绘制即一帧：结算本帧标签开销，调整质量档位
+    LabelBudget.AddCost(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+    LabelBudget.EndFrame(FLandmarkBudgetController::GetBudgetMs());
     
     // DEBUG
     /*
     if (GEngine)
     {
-         FString Stats = FString::Printf(TEXT("Landmarks: Total %d | Visible %d"), RegisteredLandmarks.Num(), VisibleLandmarkIDs.Num());
+         FString Stats = FString::Printf(TEXT("Landmarks: Total %d | Visible %d"), Landmarks.Num(), Visible.Num());
          InCanvas->DrawText(GEngine->GetLargeFont(), Stats, 100, 100);
     }
     */
 }
 
-bool ULandmarkSubsystem::ProjectWorldLocationToScreen(const FVector& WorldLocation, FVector2D& OutScreenPosition) const
+float ULandmarkSubsystem::GetViewportAspectRatio() const
 {
-	// Simple wrapper around UGameplayStatics
 	if (APlayerController* PC = UGameplayStatics::GetPlayerController(GetWorld(), 0))
 	{
-		return PC->ProjectWorldLocationToScreen(WorldLocation, OutScreenPosition, true);
+		int32 SizeX = 0;
+		int32 SizeY = 0;
+		PC->GetViewportSize(SizeX, SizeY);
+		if (SizeX > 0 && SizeY > 0)
+		{
+			return (float)SizeX / (float)SizeY;
+		}
 	}
-	return false;
+	return 16.0f / 9.0f;
+}
+
+void ULandmarkSubsystem::AddActiveCell(const FIntPoint& Cell, const FLandmarkSpatialCell& Members)
+{
+    // Height Filtering：格子按高度区间分组，只取当前高度可见的成员（平移期间高度不变，结果可以跨帧保留）
+    EligibleScratch.Reset();
+    Members.GetVisibleAt(ActiveFilterZ, EligibleScratch);
+    if (EligibleScratch.Num() > 0)
+    {
+        ActiveCells.Add(Cell, EligibleScratch);
+    }
 }
@@ -0,0 +1,429 @@
+#include "LandmarkViewCulling.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/GameViewportClient.h"
+#include "SceneView.h"
+#include "Curves/RichCurve.h"
+#include "Misc/Crc.h"
+
+namespace
+{
+	using FFootprintPolygon = TArray<FVector2D, TInlineAllocator<12>>;
+
+	/** Keeps the part of Poly where A*x + B*y + C >= 0 (Sutherland-Hodgman, one edge). */
+	void ClipPolygonByHalfPlane(FFootprintPolygon& Poly, double A, double B, double C)
+	{
+		if (Poly.Num() == 0) return;
+
+		FFootprintPolygon Out;
+		for (int32 i = 0; i < Poly.Num(); ++i)
+		{
+			const FVector2D& P = Poly[i];
+			const FVector2D& Q = Poly[(i + 1) % Poly.Num()];
+			const double DP = A * P.X + B * P.Y + C;
+			const double DQ = A * Q.X + B * Q.Y + C;
+
+			if (DP >= 0.0)
+			{
+				Out.Add(P);
+			}
+			if ((DP >= 0.0) != (DQ >= 0.0))
+			{
+				const double T = DP / (DP - DQ);
+				Out.Add(P + (Q - P) * T);
+			}
+		}
+		Poly = MoveTemp(Out);
+	}
+}
+
+bool FLandmarkGroundFootprint::Build(const FVector& CameraLocation, const FRotator& CameraRotation, float HorizontalFOV, float AspectRatio, float PlaneZ, float MaxDistance)
+{
+	Polygon.Reset();
+	Bounds = FBox2D(ForceInit);
+
+	const double Fov = FMath::Clamp(HorizontalFOV > 0.0f ? HorizontalFOV : 90.0f, 1.0f, 170.0f);
+	const double TanH = FMath::Tan(FMath::DegreesToRadians(Fov * 0.5));
+	const double TanV = TanH / FMath::Max(AspectRatio, 0.01f);
+
+	const FRotationMatrix Rot(CameraRotation);
+	const FVector Forward = Rot.GetScaledAxis(EAxis::X);
+	const FVector Right = Rot.GetScaledAxis(EAxis::Y);
+	const FVector Up = Rot.GetScaledAxis(EAxis::Z);
+
+	// 四条棱的方向（左下、右下、右上、左上）
+	const FVector Corners[4] =
+	{
+		Forward - Right * TanH - Up * TanV,
+		Forward + Right * TanH - Up * TanV,
+		Forward + Right * TanH + Up * TanV,
+		Forward - Right * TanH + Up * TanV,
+	};
+
+	// 从相机脚下以 MaxDistance 为半边长的正方形开始，依次用四个侧面裁剪
+	const double CX = CameraLocation.X;
+	const double CY = CameraLocation.Y;
+	Polygon.Add(FVector2D(CX - MaxDistance, CY - MaxDistance));
+	Polygon.Add(FVector2D(CX + MaxDistance, CY - MaxDistance));
+	Polygon.Add(FVector2D(CX + MaxDistance, CY + MaxDistance));
+	Polygon.Add(FVector2D(CX - MaxDistance, CY + MaxDistance));
+
+	const double DZ = PlaneZ - CameraLocation.Z;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		// 侧面经过相机位置；法线朝向视锥内部
+		FVector N = FVector::CrossProduct(Corners[i], Corners[(i + 1) % 4]);
+		if (FVector::DotProduct(N, Forward) < 0.0)
+		{
+			N = -N;
+		}
+		// N . (P - Cam) >= 0，在 Z = PlaneZ 上化为 A*x + B*y + C >= 0
+		ClipPolygonByHalfPlane(Polygon, N.X, N.Y, N.Z * DZ - N.X * CX - N.Y * CY);
+		if (Polygon.Num() < 3)
+		{
+			Polygon.Reset();
+			return false;
+		}
+	}
+
+	for (const FVector2D& P : Polygon)
+	{
+		Bounds += P;
+	}
+	return true;
+}
+
+void FLandmarkGroundFootprint::GetCellSpans(float CellSize, TArray<FLandmarkCellSpan>& OutSpans) const
+{
+	OutSpans.Reset();
+	if (IsEmpty() || CellSize <= 0.0f) return;
+
+	const int32 MinRow = FMath::FloorToInt(Bounds.Min.Y / CellSize);
+	const int32 MaxRow = FMath::FloorToInt(Bounds.Max.Y / CellSize);
+	OutSpans.Reserve(MaxRow - MinRow + 1);
+
+	for (int32 Row = MinRow; Row <= MaxRow; ++Row)
+	{
+		const double Y0 = (double)Row * CellSize;
+		const double Y1 = Y0 + CellSize;
+
+		// 多边形与水平条带 [Y0, Y1] 相交部分的 X 范围：各边落在条带内的线段端点
+		double MinX = TNumericLimits<double>::Max();
+		double MaxX = TNumericLimits<double>::Lowest();
+		for (int32 i = 0; i < Polygon.Num(); ++i)
+		{
+			const FVector2D& P = Polygon[i];
+			const FVector2D& Q = Polygon[(i + 1) % Polygon.Num()];
+			const double EdgeMinY = FMath::Min(P.Y, Q.Y);
+			const double EdgeMaxY = FMath::Max(P.Y, Q.Y);
+			if (EdgeMaxY < Y0 || EdgeMinY > Y1) continue;
+
+			if (FMath::IsNearlyEqual(P.Y, Q.Y))
+			{
+				MinX = FMath::Min(MinX, FMath::Min(P.X, Q.X));
+				MaxX = FMath::Max(MaxX, FMath::Max(P.X, Q.X));
+				continue;
+			}
+
+			const double ClampedY0 = FMath::Max(EdgeMinY, Y0);
+			const double ClampedY1 = FMath::Min(EdgeMaxY, Y1);
+			const double XAt0 = P.X + (Q.X - P.X) * ((ClampedY0 - P.Y) / (Q.Y - P.Y));
+			const double XAt1 = P.X + (Q.X - P.X) * ((ClampedY1 - P.Y) / (Q.Y - P.Y));
+			MinX = FMath::Min(MinX, FMath::Min(XAt0, XAt1));
+			MaxX = FMath::Max(MaxX, FMath::Max(XAt0, XAt1));
+		}
+
+		if (MinX > MaxX) continue;
+
+		FLandmarkCellSpan& Span = OutSpans.AddDefaulted_GetRef();
+		Span.Y = Row;
+		Span.MinX = FMath::FloorToInt(MinX / CellSize);
+		Span.MaxX = FMath::FloorToInt(MaxX / CellSize);
+	}
+}
+
+void ForEachCellNotIn(TConstArrayView<FLandmarkCellSpan> Spans, TConstArrayView<FLandmarkCellSpan> Exclude, TFunctionRef<void(const FIntPoint&)> Func)
+{
+	const int32 FirstExcludeRow = Exclude.Num() > 0 ? Exclude[0].Y : 0;
+
+	for (const FLandmarkCellSpan& Span : Spans)
+	{
+		const int32 Row = Span.Y - FirstExcludeRow;
+		if (!Exclude.IsValidIndex(Row) || Exclude[Row].Y != Span.Y || Exclude[Row].Num() == 0)
+		{
+			for (int32 CellX = Span.MinX; CellX <= Span.MaxX; ++CellX)
+			{
+				Func(FIntPoint(CellX, Span.Y));
+			}
+			continue;
+		}
+
+		// 同一行两个区间相减，最多剩左右两段
+		const FLandmarkCellSpan& Other = Exclude[Row];
+		for (int32 CellX = Span.MinX; CellX <= FMath::Min(Span.MaxX, Other.MinX - 1); ++CellX)
+		{
+			Func(FIntPoint(CellX, Span.Y));
+		}
+		for (int32 CellX = FMath::Max(Span.MinX, Other.MaxX + 1); CellX <= Span.MaxX; ++CellX)
+		{
+			Func(FIntPoint(CellX, Span.Y));
+		}
+	}
+}
+
+bool FLandmarkViewProjection::BuildFromPlayer(APlayerController* PC)
+{
+	ULocalPlayer* LocalPlayer = PC ? PC->GetLocalPlayer() : nullptr;
+	if (!LocalPlayer || !LocalPlayer->ViewportClient) return false;
+
+	FSceneViewProjectionData ProjectionData;
+	if (!LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData)) return false;
+
+	const FIntRect ViewRect = ProjectionData.GetConstrainedViewRect();
+	if (ViewRect.Width() <= 0 || ViewRect.Height() <= 0) return false;
+
+	// ComputeViewProjectionMatrix() = Translation(-ViewOrigin) * ViewRotation * Projection，这里去掉平移部分
+	TranslatedViewProjection = FMatrix44f(ProjectionData.ViewRotationMatrix * ProjectionData.ProjectionMatrix);
+	ViewOrigin = ProjectionData.ViewOrigin;
+	ViewSize = FVector2f((float)ViewRect.Width(), (float)ViewRect.Height());
+	return true;
+}
+
+bool FLandmarkViewProjection::BuildFromCamera(const FVector& Location, const FRotator& Rotation, float HorizontalFOV, const FIntPoint& ViewportSize)
+{
+	if (ViewportSize.X <= 0 || ViewportSize.Y <= 0) return false;
+
+	// 与 FMinimalViewInfo 相同的约定：UE 世界轴 (X 前, Y 右, Z 上) -> 视图轴 (X 右, Y 上, Z 前)
+	const FMatrix ViewRotationMatrix = FInverseRotationMatrix(Rotation) * FMatrix(
+		FPlane(0, 0, 1, 0),
+		FPlane(1, 0, 0, 0),
+		FPlane(0, 1, 0, 0),
+		FPlane(0, 0, 0, 1));
+
+	const float HalfFOV = FMath::DegreesToRadians(FMath::Max(0.001f, HorizontalFOV > 0.0f ? HorizontalFOV : 90.0f)) * 0.5f;
+	const FMatrix ProjectionMatrix = FReversedZPerspectiveMatrix(HalfFOV, (float)ViewportSize.X, (float)ViewportSize.Y, GNearClippingPlane);
+
+	TranslatedViewProjection = FMatrix44f(ViewRotationMatrix * ProjectionMatrix);
+	ViewOrigin = Location;
+	ViewSize = FVector2f((float)ViewportSize.X, (float)ViewportSize.Y);
+	return true;
+}
+
+void FLandmarkViewProjection::ProjectBatch(const float* RelX, const float* RelY, float RelZ, int32 Num, float ScreenMargin,
+	float* OutScreenX, float* OutScreenY, uint8* OutFlags) const
+{
+	const FMatrix44f& M = TranslatedViewProjection;
+
+	// 行向量约定：Clip = (x, y, z, 1) * M。Z 为常量（标签平面），合并进常数项
+	const float CX = RelZ * M.M[2][0] + M.M[3][0];
+	const float CY = RelZ * M.M[2][1] + M.M[3][1];
+	const float CW = RelZ * M.M[2][3] + M.M[3][3];
+
+	const float HalfW = ViewSize.X * 0.5f;
+	const float HalfH = ViewSize.Y * 0.5f;
+	const float MinX = -ScreenMargin;
+	const float MinY = -ScreenMargin;
+	const float MaxX = ViewSize.X + ScreenMargin;
+	const float MaxY = ViewSize.Y + ScreenMargin;
+
+	int32 i = 0;
+
+	// --- 4 路 SIMD 主循环 ---
+	{
+		const VectorRegister4Float M00 = VectorSetFloat1(M.M[0][0]);
+		const VectorRegister4Float M10 = VectorSetFloat1(M.M[1][0]);
+		const VectorRegister4Float M01 = VectorSetFloat1(M.M[0][1]);
+		const VectorRegister4Float M11 = VectorSetFloat1(M.M[1][1]);
+		const VectorRegister4Float M03 = VectorSetFloat1(M.M[0][3]);
+		const VectorRegister4Float M13 = VectorSetFloat1(M.M[1][3]);
+		const VectorRegister4Float VCX = VectorSetFloat1(CX);
+		const VectorRegister4Float VCY = VectorSetFloat1(CY);
+		const VectorRegister4Float VCW = VectorSetFloat1(CW);
+		const VectorRegister4Float VHalfW = VectorSetFloat1(HalfW);
+		const VectorRegister4Float VHalfH = VectorSetFloat1(HalfH);
+		const VectorRegister4Float VMinX = VectorSetFloat1(MinX);
+		const VectorRegister4Float VMinY = VectorSetFloat1(MinY);
+		const VectorRegister4Float VMaxX = VectorSetFloat1(MaxX);
+		const VectorRegister4Float VMaxY = VectorSetFloat1(MaxY);
+		const VectorRegister4Float VZero = VectorZeroFloat();
+		const VectorRegister4Float VOne = VectorOneFloat();
+
+		for (; i + 4 <= Num; i += 4)
+		{
+			const VectorRegister4Float X = VectorLoad(RelX + i);
+			const VectorRegister4Float Y = VectorLoad(RelY + i);
+
+			const VectorRegister4Float ClipX = VectorMultiplyAdd(X, M00, VectorMultiplyAdd(Y, M10, VCX));
+			const VectorRegister4Float ClipY = VectorMultiplyAdd(X, M01, VectorMultiplyAdd(Y, M11, VCY));
+			const VectorRegister4Float ClipW = VectorMultiplyAdd(X, M03, VectorMultiplyAdd(Y, M13, VCW));
+
+			const VectorRegister4Float InFront = VectorCompareGT(ClipW, VZero);
+			// 背面的点 W <= 0：用 1 代替避免除零，结果由掩码丢弃
+			const VectorRegister4Float SafeW = VectorSelect(InFront, ClipW, VOne);
+			const VectorRegister4Float RHW = VectorDivide(VOne, SafeW);
+
+			// NormalizedX = NDC.x * 0.5 + 0.5；NormalizedY = 0.5 - NDC.y * 0.5
+			const VectorRegister4Float SX = VectorMultiplyAdd(VectorMultiply(ClipX, RHW), VHalfW, VHalfW);
+			const VectorRegister4Float SY = VectorSubtract(VHalfH, VectorMultiply(VectorMultiply(ClipY, RHW), VHalfH));
+
+			const VectorRegister4Float OnScreen = VectorBitwiseAnd(
+				VectorBitwiseAnd(VectorCompareGE(SX, VMinX), VectorCompareLE(SX, VMaxX)),
+				VectorBitwiseAnd(VectorCompareGE(SY, VMinY), VectorCompareLE(SY, VMaxY)));
+
+			VectorStore(SX, OutScreenX + i);
+			VectorStore(SY, OutScreenY + i);
+
+			const int32 FrontBits = VectorMaskBits(InFront);
+			const int32 ScreenBits = VectorMaskBits(OnScreen);
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				OutFlags[i + Lane] = (uint8)(((FrontBits >> Lane) & 1) * ELandmarkProjection::InFront
+					| ((ScreenBits >> Lane) & 1) * ELandmarkProjection::OnScreen);
+			}
+		}
+	}
+
+	// --- 标量尾部 ---
+	for (; i < Num; ++i)
+	{
+		const float ClipX = RelX[i] * M.M[0][0] + RelY[i] * M.M[1][0] + CX;
+		const float ClipY = RelX[i] * M.M[0][1] + RelY[i] * M.M[1][1] + CY;
+		const float ClipW = RelX[i] * M.M[0][3] + RelY[i] * M.M[1][3] + CW;
+
+		const bool bInFront = ClipW > 0.0f;
+		const float RHW = 1.0f / (bInFront ? ClipW : 1.0f);
+		const float SX = ClipX * RHW * HalfW + HalfW;
+		const float SY = HalfH - ClipY * RHW * HalfH;
+		const bool bOnScreen = SX >= MinX && SX <= MaxX && SY >= MinY && SY <= MaxY;
+
+		OutScreenX[i] = SX;
+		OutScreenY[i] = SY;
+		OutFlags[i] = (bInFront ? ELandmarkProjection::InFront : 0) | (bOnScreen ? ELandmarkProjection::OnScreen : 0);
+	}
+}
+
+void FLandmarkCurveTable::Update(const FRichCurve* Curve, float DefaultValue)
+{
+	const bool bHasKeys = Curve && !Curve->IsEmpty();
+
+	uint32 Hash = FCrc::MemCrc32(&DefaultValue, sizeof(DefaultValue));
+	if (bHasKeys)
+	{
+		// 逐字段哈希：FRichCurveKey 含填充字节，不能整块 MemCrc
+		for (const FRichCurveKey& Key : Curve->GetConstRefOfKeys())
+		{
+			const float Fields[] = { Key.Time, Key.Value, Key.ArriveTangent, Key.LeaveTangent, Key.ArriveTangentWeight, Key.LeaveTangentWeight };
+			Hash = FCrc::MemCrc32(Fields, sizeof(Fields), Hash);
+			const uint8 Modes[] = { (uint8)Key.InterpMode, (uint8)Key.TangentMode, (uint8)Key.TangentWeightMode };
+			Hash = FCrc::MemCrc32(Modes, sizeof(Modes), Hash);
+		}
+	}
+	if (bBaked && Hash == SourceHash) return;
+
+	SourceHash = Hash;
+	bBaked = true;
+	Samples.SetNumUninitialized(NumSamples + 1);
+
+	if (!bHasKeys)
+	{
+		for (float& Sample : Samples)
+		{
+			Sample = DefaultValue;
+		}
+		MinDistance = 0.0f;
+		InvStep = 0.0f;
+		return;
+	}
+
+	float MinTime, MaxTime;
+	Curve->GetTimeRange(MinTime, MaxTime);
+	const float Range = FMath::Max(MaxTime - MinTime, KINDA_SMALL_NUMBER);
+	const float Step = Range / (float)NumSamples;
+
+	for (int32 i = 0; i <= NumSamples; ++i)
+	{
+		Samples[i] = Curve->Eval(MinTime + Step * (float)i, DefaultValue);
+	}
+	MinDistance = MinTime;
+	InvStep = 1.0f / Step;
+}
+
+void FLandmarkCurveTable::EvalBatch(const float* Distances, int32 Num, float* Out) const
+{
+	check(bBaked);
+	const float* RESTRICT Table = Samples.GetData();
+	const float MaxT = (float)NumSamples;
+
+	for (int32 i = 0; i < Num; ++i)
+	{
+		const float T = FMath::Clamp((Distances[i] - MinDistance) * InvStep, 0.0f, MaxT);
+		const int32 Cell = FMath::Min((int32)T, NumSamples - 1);
+		const float Frac = T - (float)Cell;
+		Out[i] = Table[Cell] + (Table[Cell + 1] - Table[Cell]) * Frac;
+	}
+}
+
+void CullCandidateRange(const FLandmarkCullInput& In, int32 Begin, int32 End, FLandmarkCullChunk& Out)
+{
+	const int32 Num = End - Begin;
+	Out.Slots.Reset();
+	Out.ScreenX.Reset();
+	Out.ScreenY.Reset();
+	Out.Scales.Reset();
+	Out.Alphas.Reset();
+	Out.Distances.Reset();
+	if (Num <= 0) return;
+
+	// 1. Project
+	Out.TempX.SetNumUninitialized(Num, EAllowShrinking::No);
+	Out.TempY.SetNumUninitialized(Num, EAllowShrinking::No);
+	Out.Flags.SetNumUninitialized(Num, EAllowShrinking::No);
+	In.Projection->ProjectBatch(In.RelX + Begin, In.RelY + Begin, In.RelZ, Num, In.ScreenMargin,
+		Out.TempX.GetData(), Out.TempY.GetData(), Out.Flags.GetData());
+
+	// 2. Compact: 到相机的距离每个标签只算一次
+	int32 NumVisible = 0;
+	Out.Distances.SetNumUninitialized(Num, EAllowShrinking::No);
+	Out.Slots.SetNumUninitialized(Num, EAllowShrinking::No);
+	for (int32 i = 0; i < Num; ++i)
+	{
+		if (Out.Flags[i] != ELandmarkProjection::Visible) continue;
+
+		const float X = In.RelX[Begin + i];
+		const float Y = In.RelY[Begin + i];
+		Out.Slots[NumVisible] = In.Slots[Begin + i];
+		Out.TempX[NumVisible] = Out.TempX[i];
+		Out.TempY[NumVisible] = Out.TempY[i];
+		Out.Distances[NumVisible] = FMath::Sqrt(X * X + Y * Y + In.RelZ * In.RelZ);
+		++NumVisible;
+	}
+
+	// 3. Scale / Alpha 查找表批量插值
+	Out.Scales.SetNumUninitialized(NumVisible, EAllowShrinking::No);
+	Out.Alphas.SetNumUninitialized(NumVisible, EAllowShrinking::No);
+	In.ScaleTable->EvalBatch(Out.Distances.GetData(), NumVisible, Out.Scales.GetData());
+	In.AlphaTable->EvalBatch(Out.Distances.GetData(), NumVisible, Out.Alphas.GetData());
+
+	// 4. 完全透明的标签直接剔除
+	int32 NumKept = 0;
+	Out.ScreenX.SetNumUninitialized(NumVisible, EAllowShrinking::No);
+	Out.ScreenY.SetNumUninitialized(NumVisible, EAllowShrinking::No);
+	for (int32 i = 0; i < NumVisible; ++i)
+	{
+		if (Out.Alphas[i] < In.MinAlpha) continue;
+
+		Out.Slots[NumKept] = Out.Slots[i];
+		Out.ScreenX[NumKept] = Out.TempX[i];
+		Out.ScreenY[NumKept] = Out.TempY[i];
+		Out.Scales[NumKept] = Out.Scales[i];
+		Out.Alphas[NumKept] = Out.Alphas[i];
+		Out.Distances[NumKept] = Out.Distances[i];
+		++NumKept;
+	}
+	Out.Slots.SetNum(NumKept, EAllowShrinking::No);
+	Out.ScreenX.SetNum(NumKept, EAllowShrinking::No);
+	Out.ScreenY.SetNum(NumKept, EAllowShrinking::No);
+	Out.Scales.SetNum(NumKept, EAllowShrinking::No);
+	Out.Alphas.SetNum(NumKept, EAllowShrinking::No);
+	Out.Distances.SetNum(NumKept, EAllowShrinking::No);
+}
@@ -0,0 +1,124 @@
+#include "LandmarkSubsystem.h"
+#include "LandmarkFileFormat.h"
+#include "LandmarkJournal.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLandmarkSaveRoundTripTest, "LandmarkSystem.Save.RegisteredRoundTrip",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/** SaveRegisteredLandmarksAsync -> LoadLandmarksFromFile 必须还原同样的引擎坐标（包括只追加日志的第二次保存） */
+bool FLandmarkSaveRoundTripTest::RunTest(const FString& Parameters)
+{
+	static const TCHAR* FileName = TEXT("Landmarks_AutomationRoundTrip.json");
+	const FString Path = FPaths::ProjectContentDir() / TEXT("MapData") / FileName;
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	ULandmarkSubsystem* Subsystem = World ? World->GetSubsystem<ULandmarkSubsystem>() : nullptr;
+	if (!TestNotNull(TEXT("Landmark subsystem"), Subsystem))
+	{
+		if (World) World->DestroyWorld(false);
+		return false;
+	}
+
+	// X != Y，轴被转置时必然不相等
+	TArray<FLandmarkInstanceData> Expected;
+	for (int32 i = 0; i < 3; ++i)
+	{
+		FLandmarkInstanceData& Data = Expected.AddDefaulted_GetRef();
+		Data.ID = FString::Printf(TEXT("RoundTrip_%d"), i);
+		Data.Name = Data.ID;
+		Data.Type = TEXT("City1");
+		Data.X = 1000.0 * (i + 1);
+		Data.Y = -250.0 * (i + 3);
+		Subsystem->RegisterLandmark(Data);
+	}
+
+	auto SaveAndReload = [&](const TCHAR* What)
+	{
+		Subsystem->SaveRegisteredLandmarksAsync(FileName, FOnLandmarkSaveComplete());
+		Subsystem->WaitForPendingSaves();
+		Subsystem->UnregisterAll();
+		TestTrue(FString::Printf(TEXT("%s: file loads"), What), Subsystem->LoadLandmarksFromFile(FileName));
+
+		for (const FLandmarkInstanceData& Data : Expected)
+		{
+			FLandmarkInstanceData Loaded;
+			const bool bFound = Subsystem->GetLandmarkData(Subsystem->FindLandmarkHandle(Data.ID), Loaded);
+			TestTrue(FString::Printf(TEXT("%s: %s is registered"), What, *Data.ID), bFound);
+			TestEqual(FString::Printf(TEXT("%s: %s X"), What, *Data.ID), Loaded.X, Data.X);
+			TestEqual(FString::Printf(TEXT("%s: %s Y"), What, *Data.ID), Loaded.Y, Data.Y);
+		}
+	};
+
+	SaveAndReload(TEXT("Full save"));
+
+	// 第二次保存只把改动追加到 .journal
+	Expected[1].X += 500.0;
+	Subsystem->UpdateLandmark(Expected[1].ID, Expected[1]);
+	SaveAndReload(TEXT("Journaled save"));
+
+	IFileManager::Get().Delete(*Path, false, false, true);
+	IFileManager::Get().Delete(*LandmarkFileFormat::GetJournalPath(Path), false, false, true);
+	World->DestroyWorld(false);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLandmarkJournalResumeTest, "LandmarkSystem.Save.JournalResumesBaseline",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/** 新的 FLandmarkJournaledFile（相当于新会话）第一次保存也只追加改动，不重写基础文件 */
+bool FLandmarkJournalResumeTest::RunTest(const FString& Parameters)
+{
+	const FString Path = FPaths::ProjectContentDir() / TEXT("MapData") / TEXT("Landmarks_AutomationJournal.json");
+	const FString JournalPath = LandmarkFileFormat::GetJournalPath(Path);
+
+	TArray<FLandmarkInstanceData> Records;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		FLandmarkInstanceData& Data = Records.AddDefaulted_GetRef();
+		Data.ID = FString::Printf(TEXT("Journal_%d"), i);
+		Data.Name = Data.ID;
+		Data.Type = TEXT("City1");
+		Data.X = 100.0 * i;
+		Data.Y = 50.0 * i;
+	}
+
+	{
+		FLandmarkJournaledFile FirstSession;
+		TestTrue(TEXT("First session writes the base"), FirstSession.Save(Path, Records, true));
+		Records[0].X += 10.0;
+		TestTrue(TEXT("First session appends"), FirstSession.Save(Path, Records, true));
+	}
+	const FDateTime BaseTimeStamp = IFileManager::Get().GetTimeStamp(*Path);
+	const int64 BaseSize = IFileManager::Get().FileSize(*Path);
+
+	FLandmarkJournaledFile SecondSession;
+	Records[2].Y -= 10.0;
+	Records.RemoveAt(3);
+	TestTrue(TEXT("Second session saves"), SecondSession.Save(Path, Records, true));
+	TestTrue(TEXT("Base file is untouched"), IFileManager::Get().GetTimeStamp(*Path) == BaseTimeStamp);
+	TestEqual(TEXT("Base file size is unchanged"), IFileManager::Get().FileSize(*Path), BaseSize);
+	TestEqual(TEXT("Journal holds both sessions' changes"), SecondSession.GetJournalLength(), 3);
+
+	TArray<FLandmarkInstanceData> Loaded;
+	TestTrue(TEXT("Journaled file loads"), FLandmarkJournaledFile::Load(Path, Loaded, true));
+	if (TestEqual(TEXT("Landmark count"), Loaded.Num(), Records.Num()))
+	{
+		for (int32 i = 0; i < Records.Num(); ++i)
+		{
+			TestEqual(FString::Printf(TEXT("%s X"), *Records[i].ID), Loaded[i].X, Records[i].X);
+			TestEqual(FString::Printf(TEXT("%s Y"), *Records[i].ID), Loaded[i].Y, Records[i].Y);
+		}
+	}
+
+	IFileManager::Get().Delete(*Path, false, false, true);
+	IFileManager::Get().Delete(*JournalPath, false, false, true);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
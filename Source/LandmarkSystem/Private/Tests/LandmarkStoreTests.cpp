@@ -0,0 +1,44 @@
+#include "LandmarkStore.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLandmarkStoreResetTest, "LandmarkSystem.Store.ResetInvalidatesHandles",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FLandmarkStoreResetTest::RunTest(const FString& Parameters)
+{
+	FLandmarkStore Store;
+
+	FLandmarkInstanceData Old;
+	Old.ID = TEXT("Old");
+	Old.Name = TEXT("Old");
+	const FLandmarkHandle OldHandle = Store.Add(FLandmarkId::FromString(Old.ID), Old);
+	TestTrue(TEXT("Handle is valid after Add"), Store.IsValid(OldHandle));
+
+	const uint32 OldRevision = Store.GetRevision(OldHandle.Index);
+	Store.Reset();
+	TestFalse(TEXT("Handle is invalid after Reset"), Store.IsValid(OldHandle));
+
+	// 新地标落在同一个槽位上，旧句柄仍不能指向它
+	FLandmarkInstanceData New;
+	New.ID = TEXT("New");
+	New.Name = TEXT("New");
+	const FLandmarkHandle NewHandle = Store.Add(FLandmarkId::FromString(New.ID), New);
+	TestEqual(TEXT("Slot is reused"), NewHandle.Index, OldHandle.Index);
+	TestTrue(TEXT("New handle is valid"), Store.IsValid(NewHandle));
+	TestFalse(TEXT("Handle from before Reset is rejected"), Store.IsValid(OldHandle));
+	TestNotEqual(TEXT("Generation changes across Reset"), NewHandle.Generation, OldHandle.Generation);
+	TestNotEqual(TEXT("Revision changes across Reset"), Store.GetRevision(NewHandle.Index), OldRevision);
+
+	// 普通的删除/复用同样使旧句柄失效
+	Store.Remove(NewHandle);
+	const FLandmarkHandle Reused = Store.Add(FLandmarkId::FromString(Old.ID), Old);
+	TestEqual(TEXT("Slot is reused after Remove"), Reused.Index, NewHandle.Index);
+	TestFalse(TEXT("Removed handle is rejected"), Store.IsValid(NewHandle));
+	TestFalse(TEXT("Handle from before Reset is still rejected"), Store.IsValid(OldHandle));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Knobs the budget controller turns down when labels exceed their frame budget. */
+struct FLandmarkLabelQuality
+{
+	/** 0 = unlimited. */
+	int32 MaxLabels = 0;
+
+	/** Labels below this priority are not drawn. */
+	int32 MinPriority = MIN_int32;
+
+	/** Draw the "N 胜利点" line under the name. */
+	bool bShowVP = true;
+
+	/** Labels farther than the far distance are re-culled only every N-th update (1 = every update). */
+	int32 FarRefreshInterval = 1;
+};
+
+/**
+ * FLandmarkBudgetController
+ *
+ * 标签开销的帧预算控制器。每帧累计 UpdateCameraState（含工作线程剔除）与 DrawLandmarks 的耗时，
+ * 指数平滑后与预算比较，在一条固定的质量阶梯上逐级升降：
+ *   远处标签降频 -> 隐藏胜利点行 -> 限制标签数 -> 只显示高优先级。
+ * 升级后等待若干帧再判断（让新设置生效），降级需要开销明显低于预算，避免来回抖动。
+ */
+class LANDMARKSYSTEM_API FLandmarkBudgetController
+{
+public:
+	/** Adds label work done this frame (any thread's cost, reported on the game thread). */
+	void AddCost(double Milliseconds) { FrameCostMs += Milliseconds; }
+
+	/**
+	 * Closes the frame and moves along the quality ladder.
+	 * @param BudgetMs  <= 0 disables the controller (full quality).
+	 */
+	void EndFrame(float BudgetMs);
+
+	const FLandmarkLabelQuality& GetQuality() const { return Quality; }
+	int32 GetLevel() const { return Level; }
+	double GetSmoothedCostMs() const { return SmoothedCostMs; }
+
+	/** Budget from the Landmark.Budget.Ms console variable, or the project setting when it is negative. */
+	static float GetBudgetMs();
+
+	static FLandmarkLabelQuality GetQualityForLevel(int32 InLevel);
+
+	static constexpr int32 NumLevels = 7;
+
+private:
+	void SetLevel(int32 NewLevel);
+
+	FLandmarkLabelQuality Quality;
+	int32 Level = 0;
+	double FrameCostMs = 0.0;
+	double SmoothedCostMs = 0.0;
+	int32 FramesSinceChange = 0;
+};
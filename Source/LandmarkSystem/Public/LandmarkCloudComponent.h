@@ -3,6 +3,7 @@
 #include "CoreMinimal.h"
 #include "Components/SceneComponent.h"
 #include "LandmarkTypes.h"
+#include "LandmarkJournal.h"
 #include "LandmarkCloudComponent.generated.h"
 
 /**
@@ -54,10 +55,18 @@ public:
     UFUNCTION(BlueprintCallable, CallInEditor, Category = "Landmark IO")
     void LoadFromJson();
 
-    /** Saves current Landmarks array to JsonFileName. */
+    /** Saves current Landmarks array to JsonFileName. After the first save only changed points are appended to its .journal. */
     UFUNCTION(BlueprintCallable, CallInEditor, Category = "Landmark IO")
     void SaveToJson();
 
+    /** Folds the .journal written by SaveToJson back into JsonFileName. */
+    UFUNCTION(BlueprintCallable, CallInEditor, Category = "Landmark IO")
+    void CompactJson();
+
 protected:
 	virtual void BeginPlay() override;
+
+private:
+    /** Hashes of the points last written, so SaveToJson can append only the difference */
+    FLandmarkJournaledFile SaveJournal;
 };
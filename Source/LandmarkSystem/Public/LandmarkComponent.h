@@ -40,6 +40,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Landmark")
 	float MaxVisibleHeight = 100000.0f;
 
+	/* Label priority. When labels overlap on screen, the higher priority one is kept. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Landmark")
+	int32 Priority = 0;
+
 	// --- Editor Visualization ---
     // We treat these as transient editor-only helpers
 #if WITH_EDITORONLY_DATA
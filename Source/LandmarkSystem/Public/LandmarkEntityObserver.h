@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassObserverProcessor.h"
+#include "LandmarkEntityObserver.generated.h"
+
+/**
+ * ULandmarkEntityObserver
+ *
+ * 城市实体在生成后会带上 FLandmarkFragment。
+ * 实体被销毁（或片段被移除）时通知 ULandmarkSubsystem 清理 实体 <-> 地标 双向索引，
+ * 保证查询永远不会返回过期句柄。
+ */
+UCLASS()
+class LANDMARKSYSTEM_API ULandmarkEntityObserver : public UMassObserverProcessor
+{
+	GENERATED_BODY()
+
+public:
+	ULandmarkEntityObserver();
+
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LandmarkTypes.h"
+#include "LandmarkStore.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+class FLandmarkSpatialIndex;
+
+/**
+ * 地标数据文件格式。
+ *
+ * - JSON（Content/MapData/Landmarks_*.json）：手写/工具导出的源数据。
+ * - 二进制（同名 .lmkb）：由 LandmarkCook 命令行工具从 JSON 生成。
+ *   记录按 Hilbert 曲线排序后以 SoA 数组存放，附带字符串表和预构建的空间索引，
+ *   运行时内存映射整个文件直接读取，不构造 DOM，也不解析文本。
+ *
+ * 二进制布局（小端，所有段 16 字节对齐，偏移均相对文件起始）：
+ *   FLandmarkBinaryHeader
+ *   Keys u64[N] | X f64[N] | Y f64[N] | ZMin f32[N] | ZMax f32[N] | Value i32[N] | Team i32[N] | Priority i32[N]
+ *   VisualOffset f64[3N] | IdString u32[N] | NameString u32[N] | TypeString u32[N] | RepresentationString u32[N]
+ *   StringOffsets u32[S + 1] | StringBlob (UTF-8, 不含结尾 0；字符串 0 恒为空串)
+ *   Cells FLandmarkBinaryCell[C] | CellMembers u32[M]（记录下标）
+ *
+ * 日志（同名 .journal，JSON Lines，UTF-8）：每行一个操作，按键作用在基础文件的记录上，
+ *   {"Op":"Update","Key":"#0123456789abcdef","Data":{...}}   {"Op":"Remove","Key":"#..."}
+ * 压缩时把日志折叠回基础文件并删除日志。见 FLandmarkJournaledFile。
+ */
+/** One line of a landmark journal. Add and Update both replace the whole record. */
+enum class ELandmarkJournalOp : uint8
+{
+	Add,
+	Update,
+	Remove,
+};
+
+struct FLandmarkJournalEntry
+{
+	ELandmarkJournalOp Op = ELandmarkJournalOp::Add;
+	FLandmarkId Key;
+
+	/** Index into the record array passed to AppendJournal; unused for Remove. */
+	int32 Record = INDEX_NONE;
+};
+
+namespace LandmarkFileFormat
+{
+	/** 'LMKB' */
+	static constexpr uint32 BinaryMagic = 0x424B4D4C;
+	static constexpr uint32 BinaryVersion = 1;
+
+	/** Extension of cooked files, next to the JSON source. */
+	static const TCHAR* const BinaryExtension = TEXT(".lmkb");
+
+	/** Extension of the change journal, next to the JSON base file. */
+	static const TCHAR* const JournalExtension = TEXT(".journal");
+
+	/**
+	 * Parses a JSON array of landmark objects, appending to OutRecords.
+	 * 逐个 token 直接写入记录，不构建 DOM、不走反射；X/Y 映射到引擎轴（文件 X = 东 -> 引擎 Y）。
+	 */
+	LANDMARKSYSTEM_API bool ParseJson(const FString& JsonString, TArray<FLandmarkInstanceData>& OutRecords, bool bMapAxes = true);
+
+	/** Same as ParseJson, streaming the file in blocks so only the records are held in memory. */
+	LANDMARKSYSTEM_API bool ReadJsonFile(const FString& Path, TArray<FLandmarkInstanceData>& OutRecords, bool bMapAxes = true);
+
+	/**
+	 * Appends Data as one JSON object. bMapAxes writes engine Y as file X (the inverse of ParseJson);
+	 * without it fields are written as stored, as the reflected struct would be.
+	 */
+	LANDMARKSYSTEM_API void AppendJsonRecord(FString& Out, const FLandmarkInstanceData& Data, bool bMapAxes);
+
+	/** Writes a JSON array, one record per line (UTF-8), to a temporary file that is flushed to disk and then renamed over Path, so a crash never leaves a partial file. */
+	LANDMARKSYSTEM_API bool WriteJsonFile(const FString& Path, const TArray<FLandmarkInstanceData>& Records, bool bMapAxes);
+
+	/**
+	 * Keys exactly as RegisterLandmark would assign them when registering Records in order.
+	 * Records whose ID repeats an earlier one get an unset key (registration keeps the first).
+	 */
+	LANDMARKSYSTEM_API void AssignKeys(const TArray<FLandmarkInstanceData>& Records, TArray<FLandmarkId>& OutKeys);
+
+	LANDMARKSYSTEM_API FString GetJournalPath(const FString& BasePath);
+
+	/** Appends Entries in a single flushed write. Record data is taken from Records[Entry.Record]. */
+	LANDMARKSYSTEM_API bool AppendJournal(const FString& JournalPath, TConstArrayView<FLandmarkJournalEntry> Entries, const TArray<FLandmarkInstanceData>& Records, bool bMapAxes);
+
+	/**
+	 * Applies the journal at JournalPath (if any) to records read from its base file, keeping their order;
+	 * added records are appended. A malformed line (e.g. cut short by a crash) is skipped. Returns the number of operations applied.
+	 */
+	LANDMARKSYSTEM_API int32 ReplayJournal(const FString& JournalPath, TArray<FLandmarkInstanceData>& InOutRecords, bool bMapAxes);
+
+	/**
+	 * Cooks records to the binary format.
+	 * Keys are assigned in input order exactly as RegisterLandmark would (duplicates keep the first record),
+	 * then records are sorted along a Hilbert curve and the spatial index is built with the given parameters.
+	 */
+	LANDMARKSYSTEM_API bool WriteBinary(const FString& Path, const TArray<FLandmarkInstanceData>& Records, float SpatialBaseCellSize, float SpatialBaseAltitude);
+
+	/** Position of (X, Y) along a 2^16 x 2^16 Hilbert curve over Bounds. */
+	LANDMARKSYSTEM_API uint32 HilbertIndex(double X, double Y, const FBox2D& Bounds);
+}
+
+enum class ELandmarkBinarySection : uint8
+{
+	Keys,
+	X,
+	Y,
+	ZMin,
+	ZMax,
+	Value,
+	Team,
+	Priority,
+	VisualOffset,
+	IdString,
+	NameString,
+	TypeString,
+	RepresentationString,
+	StringOffsets,
+	StringBlob,
+	Cells,
+	CellMembers,
+	Num
+};
+
+struct FLandmarkBinaryHeader
+{
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 NumRecords = 0;
+	uint32 NumStrings = 0;
+	uint32 NumCells = 0;
+	uint32 NumCellMembers = 0;
+
+	/** Spatial index parameters the cooked cells were built with. */
+	float SpatialBaseCellSize = 0.0f;
+	float SpatialBaseAltitude = 0.0f;
+
+	uint64 StringBlobSize = 0;
+	uint64 Offsets[(int32)ELandmarkBinarySection::Num] = {};
+};
+
+/** One occupied cell of the cooked spatial index. */
+struct FLandmarkBinaryCell
+{
+	int32 Level = 0;
+	int32 CellX = 0;
+	int32 CellY = 0;
+	uint32 FirstMember = 0;
+	uint32 NumMembers = 0;
+};
+
+/**
+ * FLandmarkBinaryFile
+ *
+ * 只读访问一个 .lmkb 文件。优先内存映射；平台不支持映射时整块读入内存。
+ * 打开时校验魔数、版本与各段边界，之后的访问不再检查。
+ */
+class LANDMARKSYSTEM_API FLandmarkBinaryFile
+{
+public:
+	FLandmarkBinaryFile();
+	~FLandmarkBinaryFile();
+
+	bool Open(const FString& Path);
+	void Close();
+
+	int32 Num() const { return Header ? (int32)Header->NumRecords : 0; }
+	const FLandmarkBinaryHeader& GetHeader() const { return *Header; }
+
+	template<typename T>
+	const T* GetSection(ELandmarkBinarySection Section) const
+	{
+		return reinterpret_cast<const T*>(Data + Header->Offsets[(int32)Section]);
+	}
+
+	FLandmarkId GetKey(int32 Index) const { FLandmarkId Key; Key.Value = GetSection<uint64>(ELandmarkBinarySection::Keys)[Index]; return Key; }
+
+	FString GetString(uint32 StringIndex) const;
+
+	/** Fills every serialized field of record Index. */
+	void MakeRecord(int32 Index, FLandmarkInstanceData& Out) const;
+
+	/**
+	 * Writes the prebuilt cells into Index, mapping record i to slot SlotOf[i].
+	 * Returns false (and leaves Index untouched) if Index was configured with other parameters than the cook.
+	 */
+	bool FillSpatialIndex(FLandmarkSpatialIndex& Index, TConstArrayView<int32> SlotOf) const;
+
+	TConstArrayView<FLandmarkBinaryCell> GetCells() const { return MakeArrayView(GetSection<FLandmarkBinaryCell>(ELandmarkBinarySection::Cells), (int32)Header->NumCells); }
+	const uint32* GetCellMembers() const { return GetSection<uint32>(ELandmarkBinarySection::CellMembers); }
+
+private:
+	bool Validate();
+
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray64<uint8> FallbackData;
+
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	const FLandmarkBinaryHeader* Header = nullptr;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LandmarkFileFormat.h"
+
+/**
+ * FLandmarkJournaledFile
+ *
+ * 增量保存一个地标 JSON 文件（基础文件 + 同名 .journal 追加日志）。
+ * - 本对象还没写过该文件（新会话的第一次保存）或文件在外部被改动时，先读取磁盘上的基础文件 + 日志，以其内容哈希为基线。
+ * - 基础文件不存在、日志尾部是写入中断留下的半行或日志超过压缩阈值时，整体重写基础文件并删除日志。
+ * - 其余保存只比较哈希，把新增/修改/删除的记录一次追加到日志：写入量只与改动数量有关，与地图规模无关。
+ * - 读取 = 基础文件 + 重放日志。
+ * bMapAxes 只决定内存中的坐标如何对应文件字段（见 LandmarkFileFormat::AppendJsonRecord）；换用另一种约定保存时按新约定重新读取基线。
+ */
+class LANDMARKSYSTEM_API FLandmarkJournaledFile
+{
+public:
+	/** Journals longer than this (and than a quarter of the records) are folded into the base on the next save. */
+	static constexpr int32 MinCompactOps = 1024;
+
+	/** Reads the base file and replays its journal. A missing base with a journal starts from an empty set. */
+	static bool Load(const FString& BasePath, TArray<FLandmarkInstanceData>& OutRecords, bool bMapAxes);
+
+	/** Folds the journal into the base file and deletes it. */
+	static bool Compact(const FString& BasePath, bool bMapAxes);
+
+	/** Saves the full set Records to BasePath, appending only the difference to the last save when possible. */
+	bool Save(const FString& BasePath, const TArray<FLandmarkInstanceData>& Records, bool bMapAxes);
+
+	/** Operations in the journal since the base file was last written. */
+	int32 GetJournalLength() const { return JournalOps; }
+
+private:
+	bool RewriteBase(const FString& InBasePath, const TArray<FLandmarkInstanceData>& Records, const TArray<FLandmarkId>& Keys, bool bMapAxes);
+
+	/** Takes the baseline from the files already on disk (base + journal), so the next save can append. */
+	bool SeedBaseline(const FString& InBasePath, bool bMapAxes);
+
+	/** Whether the files on disk are still exactly what this object last wrote. */
+	bool IsBaselineValid(const FString& InBasePath) const;
+
+	static uint64 HashRecord(const FLandmarkInstanceData& Data);
+
+	FString BasePath;
+	bool bBaseMapAxes = false;
+	TMap<FLandmarkId, uint64> SavedHashes;
+	FDateTime BaseTimeStamp;
+	int64 BaseSize = INDEX_NONE;
+	int64 JournalSize = INDEX_NONE;
+	int32 JournalOps = 0;
+};
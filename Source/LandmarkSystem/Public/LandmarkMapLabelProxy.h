@@ -38,6 +38,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Landmark")
 	float MaxVisibleHeight = 100000.0f;
 
+	/* Label priority. When labels overlap on screen, the higher priority one is kept. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Landmark")
+	int32 Priority = 0;
+
 	// Visual Components
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Landmark")
 	TObjectPtr<USceneComponent> SceneComponent;
@@ -42,6 +42,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Landmark")
 	float MaxVisibleHeight = 100000.0f;
 
+	/* Label priority. When labels overlap on screen, the higher priority one is kept. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Landmark")
+	int32 Priority = 0;
+
 protected:
 	virtual void BeginPlay() override;
 
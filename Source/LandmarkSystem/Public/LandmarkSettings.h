@@ -52,6 +52,79 @@ public:
 	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "City Configs")
 	float BaseFontScale = 1.0f;
 
+	/** 标签最远可见水平距离，视锥地面投影在此截断；0 表示自动（max(20000, 相机高度 * 4)） */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "City Configs", meta = (ClampMin = "0.0"))
+	float MaxLabelDistance = 0.0f;
+
+	/** 空间索引第 0 层格子边长；第 k 层为其 2^k 倍 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Spatial Index", meta = (ClampMin = "64.0"))
+	float SpatialBaseCellSize = 4096.0f;
+
+	/** 空间索引第 0 层对应的相机高度；相机高度每翻一倍，查询切换到格子大一倍的层 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Spatial Index", meta = (ClampMin = "100.0"))
+	float SpatialBaseAltitude = 10000.0f;
+
+	/** 标签可见性剔除在工作线程上异步执行（双缓冲），游戏线程只提交相机快照；关闭则在调用线程同步剔除 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Performance")
+	bool bAsyncVisibility = true;
+
+	/** 地图数据在世界创建时于后台线程读取与解析，完成后再注册并生成城市；关闭则在 OnWorldBeginPlay 中同步加载（测试/服务器） */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Performance")
+	bool bAsyncMapDataLoad = true;
+
+	/**
+	 * 地图数据按瓦片流式加载（需先用 LandmarkCook -TileSize=<cm> 烘焙瓦片）：只有相机足迹周围的瓦片常驻内存。
+	 * 流式加载的地标只有标签，不生成城市实体；城市数据请用整体加载的地图文件。
+	 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Streaming")
+	bool bStreamLandmarkTiles = false;
+
+	/** 视野足迹之外仍保持常驻的距离（厘米） */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Streaming", meta = (ClampMin = "0.0"))
+	float TileResidencyRadius = 50000.0f;
+
+	/** 足迹之外的瓦片可占用的内存上限（MB，按烘焙瓦片大小估算）；足迹内的瓦片总是加载。0 表示不限 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Streaming", meta = (ClampMin = "0"))
+	int32 TileMemoryBudgetMB = 64;
+
+	/** 编辑器 PIE 中监视已加载的地图数据文件，保存后按 ID 增量重载（只重新注册、重新生成有改动的地标） */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Editor")
+	bool bHotReloadMapData = true;
+
+	/**
+	 * 地图城市实体分帧生成：按到初始相机的距离由近到远，每帧受下面两个预算限制；标签在注册后即显示，不等实体。
+	 * 专用服务器总是一次生成完毕；关闭则在 BeginPlay 当帧全部生成
+	 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Performance")
+	bool bTimeSliceCitySpawn = true;
+
+	/** 分帧生成时每帧最多生成的城市实体数；0 表示不限 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Performance", meta = (ClampMin = "0", EditCondition = "bTimeSliceCitySpawn"))
+	int32 CitySpawnEntitiesPerFrame = 2000;
+
+	/** 分帧生成时每帧用于生成城市实体的时间（毫秒）；0 表示不限。每帧至少生成一批 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Performance", meta = (ClampMin = "0.0", EditCondition = "bTimeSliceCitySpawn"))
+	float CitySpawnBudgetMs = 4.0f;
+
+	/** 标签去重叠：按优先级、类型、距离依次放置，与已放置标签在屏幕上重叠的标签不绘制 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Declutter")
+	bool bDeclutterLabels = true;
+
+	/** 去重叠占用格的边长（像素）。越大越保守、越快 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Declutter", meta = (ClampMin = "4", ClampMax = "256"))
+	int32 DeclutterCellSize = 16;
+
+	/** 每帧最多绘制的标签数；0 表示不限 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Declutter", meta = (ClampMin = "0"))
+	int32 MaxVisibleLabels = 0;
+
+	/**
+	 * 标签每帧开销预算（毫秒，剔除 + 绘制）。超出时逐级降低质量：远处标签降频、隐藏胜利点行、限制标签数、只显示高优先级。
+	 * 0 表示关闭（默认，始终全质量）。控制台变量 Landmark.Budget.Ms 可在运行时覆盖。
+	 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "Budget", meta = (ClampMin = "0.0"))
+	float LabelBudgetMs = 0.0f;
+
 	/** City1~City5 各等级的配置，按等级顺序排列 */
 	UPROPERTY(config, EditAnywhere, BlueprintReadOnly, Category = "City Configs",
 		meta = (TitleProperty = "TypeName"))
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LandmarkViewCulling.h"
+
+/**
+ * FLandmarkSpatialCell
+ *
+ * 一个格子的成员，按可见高度区间 [ZMin, ZMax] 与所在层高度带 [BandMin, BandMax) 的关系分两组：
+ * - Full:    区间覆盖整个高度带，相机在本层时一定可见，无需逐个判断。
+ * - Partial: 只覆盖高度带的一部分，按 ZMin 升序存放，ZMax 平行存放；
+ *            查询时二分出 ZMin <= Z 的前缀，再只读连续的 ZMax 判断。
+ * 另存所有成员的并集区间，相机高度落在其外时整个格子直接跳过，不触碰成员。
+ */
+struct LANDMARKSYSTEM_API FLandmarkSpatialCell
+{
+	TArray<int32> Full;
+
+	TArray<int32> Partial;
+	TArray<float> PartialZMin;
+	TArray<float> PartialZMax;
+
+	/** Union of all members' visibility intervals. */
+	float MinZ = TNumericLimits<float>::Max();
+	float MaxZ = TNumericLimits<float>::Lowest();
+
+	int32 Num() const { return Full.Num() + Partial.Num(); }
+
+	bool IsAnyVisibleAt(float Altitude) const { return Altitude >= MinZ && Altitude <= MaxZ; }
+
+	/** Appends the members with ZMin <= Altitude <= ZMax. Altitude must lie in the cell's level band. */
+	void GetVisibleAt(float Altitude, TArray<int32>& Out) const;
+
+	void Add(int32 Index, float ZMin, float ZMax, float BandMin, float BandMax);
+	void Remove(int32 Index);
+
+	/** Add without the duplicate check, for bulk loads whose members are known to be unique. */
+	void AddUnchecked(int32 Index, float ZMin, float ZMax, float BandMin, float BandMax);
+
+	void Reserve(int32 Num);
+
+private:
+	void RecomputeBounds();
+
+	/** Full members keep their interval here only to maintain MinZ/MaxZ on removal. */
+	TArray<float> FullZMin;
+	TArray<float> FullZMax;
+};
+
+/**
+ * FLandmarkSpatialIndex
+ *
+ * 多分辨率（金字塔）空间索引。
+ * - 第 k 层格子边长为 BaseCellSize * 2^k，对应相机高度区间 [BaseAltitude * 2^k, BaseAltitude * 2^(k+1))；
+ *   第 0 层向下、最高层向上不设界。
+ * - 地标只写入与其 [ZMin, ZMax] 可见高度区间相交的层，因此某一层里只有"该高度下可能可见"的地标。
+ * - 查询按相机高度选层：格子边长与高度同比增长，视野覆盖的格子数近似为常数，
+ *   开销随可见标签数增长，而不是随高度平方增长，也无需硬性裁剪搜索半径。
+ */
+class LANDMARKSYSTEM_API FLandmarkSpatialIndex
+{
+public:
+	static constexpr int32 MaxLevels = 20;
+
+	/** Rebuilds the empty level table. Existing members are dropped. */
+	void Configure(float InBaseCellSize, float InBaseAltitude);
+
+	void Add(int32 Index, double X, double Y, float ZMin, float ZMax);
+	void Remove(int32 Index, double X, double Y, float ZMin, float ZMax);
+	void Reset();
+
+	float GetBaseCellSize() const { return BaseCellSize; }
+	float GetBaseAltitude() const { return BaseAltitude; }
+
+	/**
+	 * 批量加载：直接把成员写入指定格子，跳过逐点的层范围计算与去重。
+	 * 用于 .lmkb 里预构建的格子表，调用方保证 (Level, Cell) 与 Add 的结果一致且成员不重复。
+	 */
+	void ReserveCells(int32 Level, int32 Num) { Levels[Level].Cells.Reserve(Num); }
+	FLandmarkSpatialCell& FindOrAddCell(int32 Level, const FIntPoint& Cell) { return Levels[Level].Cells.FindOrAdd(Cell); }
+
+	/** Level whose cell size matches the camera altitude. */
+	int32 SelectLevel(float Altitude) const;
+
+	float GetCellSize(int32 Level) const { return BaseCellSize * (float)(1 << Level); }
+
+	/** Camera altitude band [OutMin, OutMax) served by Level; open-ended at the first and last level. */
+	void GetLevelBand(int32 Level, float& OutMin, float& OutMax) const;
+
+	FIntPoint GetCell(int32 Level, double X, double Y) const
+	{
+		const double CellSize = GetCellSize(Level);
+		return FIntPoint(FMath::FloorToInt(X / CellSize), FMath::FloorToInt(Y / CellSize));
+	}
+
+	const FLandmarkSpatialCell* FindCell(int32 Level, const FIntPoint& Cell) const { return Levels[Level].Cells.Find(Cell); }
+
+	int32 NumOccupiedCells(int32 Level) const { return Levels[Level].Cells.Num(); }
+
+	/** Calls Func(const FIntPoint& Cell, const FLandmarkSpatialCell& Members) for every occupied cell of Level, in no particular order. */
+	template<typename FuncType>
+	void ForEachCell(int32 Level, FuncType&& Func) const
+	{
+		for (const TPair<FIntPoint, FLandmarkSpatialCell>& Pair : Levels[Level].Cells)
+		{
+			Func(Pair.Key, Pair.Value);
+		}
+	}
+
+	/**
+	 * Calls Func(const FIntPoint& Cell, const FLandmarkSpatialCell& Members) for every occupied cell of Level covered by Spans (ascending Y)
+	 * that has a member visible at Altitude. Probes the span cells or walks the level's occupied cells, whichever is smaller.
+	 */
+	template<typename FuncType>
+	void ForEachCellInSpans(int32 Level, TConstArrayView<FLandmarkCellSpan> Spans, float Altitude, FuncType&& Func) const
+	{
+		if (Spans.Num() == 0) return;
+
+		const TMap<FIntPoint, FLandmarkSpatialCell>& Cells = Levels[Level].Cells;
+		int64 SpanCells = 0;
+		for (const FLandmarkCellSpan& Span : Spans)
+		{
+			SpanCells += Span.Num();
+		}
+
+		if (SpanCells > Cells.Num())
+		{
+			const int32 FirstRow = Spans[0].Y;
+			for (const TPair<FIntPoint, FLandmarkSpatialCell>& Pair : Cells)
+			{
+				const int32 Row = Pair.Key.Y - FirstRow;
+				if (Pair.Value.IsAnyVisibleAt(Altitude) && Spans.IsValidIndex(Row) && Spans[Row].Y == Pair.Key.Y && Pair.Key.X >= Spans[Row].MinX && Pair.Key.X <= Spans[Row].MaxX)
+				{
+					Func(Pair.Key, Pair.Value);
+				}
+			}
+			return;
+		}
+
+		for (const FLandmarkCellSpan& Span : Spans)
+		{
+			for (int32 CellX = Span.MinX; CellX <= Span.MaxX; ++CellX)
+			{
+				const FIntPoint Cell(CellX, Span.Y);
+				const FLandmarkSpatialCell* Members = Cells.Find(Cell);
+				if (Members && Members->IsAnyVisibleAt(Altitude))
+				{
+					Func(Cell, *Members);
+				}
+			}
+		}
+	}
+
+private:
+	/** Inclusive level range whose altitude band intersects [ZMin, ZMax]. */
+	void GetLevelRange(float ZMin, float ZMax, int32& OutFirst, int32& OutLast) const;
+
+	struct FLevel
+	{
+		TMap<FIntPoint, FLandmarkSpatialCell> Cells;
+	};
+
+	float BaseCellSize = 4096.0f;
+	float BaseAltitude = 10000.0f;
+	FLevel Levels[MaxLevels];
+};
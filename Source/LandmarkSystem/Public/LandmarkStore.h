@@ -0,0 +1,241 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LandmarkTypes.h"
+#include "LandmarkStore.generated.h"
+
+/**
+ * Stable reference to a landmark slot in FLandmarkStore.
+ * 地标句柄：槽位索引 + 代数。槽位被回收复用后，旧句柄的代数不再匹配，自动失效。
+ */
+USTRUCT(BlueprintType)
+struct LANDMARKSYSTEM_API FLandmarkHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Index = INDEX_NONE;
+
+	UPROPERTY()
+	int32 Generation = 0;
+
+	FLandmarkHandle() {}
+	FLandmarkHandle(int32 InIndex, int32 InGeneration) : Index(InIndex), Generation(InGeneration) {}
+
+	bool IsSet() const { return Index != INDEX_NONE; }
+
+	bool operator==(const FLandmarkHandle& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+	bool operator!=(const FLandmarkHandle& Other) const { return !(*this == Other); }
+
+	friend uint32 GetTypeHash(const FLandmarkHandle& Handle)
+	{
+		return HashCombine(::GetTypeHash(Handle.Index), ::GetTypeHash(Handle.Generation));
+	}
+};
+
+/**
+ * Compact 64-bit landmark key.
+ * 地标 ID 在注册时只做一次哈希（内部化），此后查找、格子、可见列表都只处理整数。
+ * - 有 ID：对 ID 的小写形式做 CityHash64，跨运行稳定，可用于存档与比对。
+ * - 无 ID：对内容（类型、名称、坐标、阵营）做哈希；完全相同的内容以序号加盐区分。
+ * - 文本形式为 "#" + 16 位十六进制，回传给 FromString 时直接解析为同一个键。
+ */
+struct LANDMARKSYSTEM_API FLandmarkId
+{
+	uint64 Value = 0;
+
+	FLandmarkId() {}
+	explicit FLandmarkId(uint64 InValue) : Value(InValue) {}
+
+	bool IsSet() const { return Value != 0; }
+
+	/** Key for an authored ID string (or a previously printed key). */
+	static FLandmarkId FromString(const FString& ID);
+
+	/** Key derived from content, for entries without an authored ID. */
+	static FLandmarkId FromContent(const FLandmarkInstanceData& Data, uint32 Salt = 0);
+
+	FString ToString() const;
+
+	bool operator==(const FLandmarkId& Other) const { return Value == Other.Value; }
+	bool operator!=(const FLandmarkId& Other) const { return Value != Other.Value; }
+
+	friend uint32 GetTypeHash(const FLandmarkId& Id) { return ::GetTypeHash(Id.Value); }
+};
+
+/**
+ * Fields that are only read when a label is drawn or handed back to gameplay.
+ * 冷数据：剔除循环不会访问这些字段。
+ */
+struct FLandmarkColdData
+{
+	/** 原始 ID 字符串；无 ID 的条目保持为空，以便保存后重新加载得到同一个内容键 */
+	FString ID;
+	FString Name;
+	FString Type;
+	TWeakObjectPtr<AActor> LinkedActor;
+	FVector VisualOffset = FVector::ZeroVector;
+	TSoftClassPtr<AActor> RepresentationClass;
+	FMassEntityHandle EntityHandle;
+};
+
+/**
+ * Dense copy of the fields FLandmarkInstanceData serialization needs, taken by FLandmarkStore::MakeSaveSnapshot.
+ * 保存快照：只含活动槽位、只含写入文件的字段（无索引表、实体绑定与 Actor 引用），可交给工作线程展开为记录。
+ */
+struct LANDMARKSYSTEM_API FLandmarkSaveSnapshot
+{
+	struct FColdFields
+	{
+		/** 已按 MakeInstanceData 的规则解析：无 ID 的条目为键的文本形式 */
+		FString ID;
+		FString Name;
+		FString Type;
+		FVector VisualOffset = FVector::ZeroVector;
+		TSoftClassPtr<AActor> RepresentationClass;
+	};
+
+	TArray<double> X;
+	TArray<double> Y;
+	TArray<float> ZMin;
+	TArray<float> ZMax;
+	TArray<int32> Values;
+	TArray<int32> Teams;
+	TArray<int32> Priorities;
+	TArray<FColdFields> Cold;
+
+	int32 Num() const { return X.Num(); }
+
+	/** Same record as FLandmarkStore::MakeInstanceData for the I-th live slot, minus the runtime bindings. */
+	FLandmarkInstanceData MakeInstanceData(int32 I) const;
+};
+
+/**
+ * FLandmarkStore
+ *
+ * 结构数组 (SoA) 形式的地标存储。
+ * - 热数据（位置、高度区间、分值、阵营、类型 ID）各自连续存放，剔除只触碰这些数组。
+ * - 名称等冷数据放在独立的表中。
+ * - 槽位通过空闲列表复用，外部一律通过 FLandmarkHandle 访问。
+ */
+class LANDMARKSYSTEM_API FLandmarkStore
+{
+public:
+	/** Adds a landmark under Key. The caller is responsible for making Key unique. */
+	FLandmarkHandle Add(FLandmarkId Key, const FLandmarkInstanceData& Data);
+
+	/** Overwrites every field of an existing landmark. The key is kept. */
+	void Set(FLandmarkHandle Handle, const FLandmarkInstanceData& Data);
+
+	bool Remove(FLandmarkHandle Handle);
+
+	/** Removes every landmark. Handles taken before the reset stay invalid, even once their slots are reused. */
+	void Reset();
+
+	/** Pre-sizes the slot arrays and key map for a bulk load of Num more landmarks. */
+	void Reserve(int32 Num);
+
+	bool IsValid(FLandmarkHandle Handle) const
+	{
+		return Alive.IsValidIndex(Handle.Index) && Alive[Handle.Index] && Generations[Handle.Index] == Handle.Generation;
+	}
+
+	bool IsAlive(int32 Index) const { return Alive.IsValidIndex(Index) && Alive[Index]; }
+
+	/** Handle for a live slot, or an unset handle. */
+	FLandmarkHandle GetHandle(int32 Index) const
+	{
+		return IsAlive(Index) ? FLandmarkHandle(Index, Generations[Index]) : FLandmarkHandle();
+	}
+
+	FLandmarkHandle FindByKey(FLandmarkId Key) const;
+	FLandmarkHandle FindByID(const FString& ID) const { return FindByKey(FLandmarkId::FromString(ID)); }
+
+	FLandmarkId GetKey(int32 Index) const { return Keys[Index]; }
+
+	/** Binds (or with an unset handle, unbinds) the Mass entity of a slot, keeping the reverse index in sync. */
+	void SetEntity(int32 Index, const FMassEntityHandle& Entity);
+
+	/** Drops the binding only if the slot still points at exactly this entity (index + serial). */
+	bool ClearEntity(const FMassEntityHandle& Entity);
+
+	FLandmarkHandle FindByEntity(const FMassEntityHandle& Entity) const;
+	const FMassEntityHandle& GetEntity(int32 Index) const { return Cold[Index].EntityHandle; }
+
+	/** Rebuilds the reflected struct for a slot (cold path: Blueprint/UI, saving). */
+	FLandmarkInstanceData MakeInstanceData(int32 Index) const;
+
+	/** Copies what saving needs from every live slot, in ascending slot order. */
+	FLandmarkSaveSnapshot MakeSaveSnapshot() const;
+
+	/** Number of live landmarks. */
+	int32 Num() const { return NumAlive; }
+
+	/** Number of slots, live or free. Hot arrays are sized to this. */
+	int32 NumSlots() const { return Alive.Num(); }
+
+	int32 FindOrAddTypeId(const FString& TypeName);
+	const FString& GetTypeName(int32 TypeId) const { return TypeNames[TypeId]; }
+
+	// --- Hot arrays (indexed by slot) ---
+	const TArray<double>& GetX() const { return X; }
+	const TArray<double>& GetY() const { return Y; }
+	const TArray<float>& GetZMin() const { return ZMin; }
+	const TArray<float>& GetZMax() const { return ZMax; }
+	const TArray<int32>& GetValues() const { return Values; }
+	const TArray<int32>& GetTeams() const { return Teams; }
+	const TArray<int32>& GetPriorities() const { return Priorities; }
+	const TArray<int32>& GetTypeIds() const { return TypeIds; }
+
+	FVector2D GetLocation2D(int32 Index) const { return FVector2D(X[Index], Y[Index]); }
+
+	void SetValue(int32 Index, int32 InValue) { Values[Index] = InValue; ++Revisions[Index]; }
+
+	/** Bumped on every write to a slot's fields; caches keyed by (slot, generation) compare it to detect edits. */
+	uint32 GetRevision(int32 Index) const { return Revisions[Index]; }
+
+	// --- Cold table ---
+	const FLandmarkColdData& GetCold(int32 Index) const { return Cold[Index]; }
+	FLandmarkColdData& GetMutableCold(int32 Index) { ++Revisions[Index]; return Cold[Index]; }
+
+	/** Calls Func(Index) for every live slot in ascending slot order. */
+	template<typename FuncType>
+	void ForEachAlive(FuncType&& Func) const
+	{
+		for (int32 Index = 0; Index < Alive.Num(); ++Index)
+		{
+			if (Alive[Index])
+			{
+				Func(Index);
+			}
+		}
+	}
+
+private:
+	void WriteSlot(int32 Index, const FLandmarkInstanceData& Data);
+
+	TArray<double> X;
+	TArray<double> Y;
+	TArray<float> ZMin;
+	TArray<float> ZMax;
+	TArray<int32> Values;
+	TArray<int32> Teams;
+	TArray<int32> Priorities;
+	TArray<int32> TypeIds;
+
+	/** Indexed by slot like the hot arrays, but kept across Reset (and may be longer than Alive). */
+	TArray<int32> Generations;
+	TArray<uint32> Revisions;
+	TBitArray<> Alive;
+	TArray<int32> FreeSlots;
+	int32 NumAlive = 0;
+
+	TArray<FLandmarkColdData> Cold;
+	TArray<FLandmarkId> Keys;
+
+	TMap<FLandmarkId, int32> SlotByKey;
+	TMap<FMassEntityHandle, int32> SlotByEntity;
+
+	TArray<FString> TypeNames;
+	TMap<FString, int32> TypeIdByName;
+};
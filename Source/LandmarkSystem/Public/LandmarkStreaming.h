@@ -0,0 +1,138 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LandmarkStore.h"
+#include "Tasks/Task.h"
+
+/** One cooked tile listed in a tile manifest. */
+struct FLandmarkTileInfo
+{
+	int32 NumRecords = 0;
+
+	/** Size of the cooked tile file, used as its residency cost. */
+	int64 Bytes = 0;
+};
+
+/**
+ * FLandmarkTileManifest
+ *
+ * 按固定边长切分的地标数据（LandmarkCook -TileSize 的产物）：
+ * <Json 名>_Tiles/ 目录下每个非空瓦片一个 Tile_<X>_<Y>.lmkb，外加列出所有瓦片的 Tiles.json。
+ * 键在切分前对整个文件统一分配，瓦片之间不会重复。
+ */
+struct LANDMARKSYSTEM_API FLandmarkTileManifest
+{
+	static constexpr int32 Version = 1;
+
+	FString Directory;
+	float TileSize = 0.0f;
+	TMap<FIntPoint, FLandmarkTileInfo> Tiles;
+
+	/** <Dir>/<Name>_Tiles for <Dir>/<Name>.json. */
+	static FString GetTileDirectory(const FString& JsonPath);
+	static FString GetManifestPath(const FString& TileDirectory);
+
+	FString GetTilePath(const FIntPoint& Tile) const;
+
+	FIntPoint GetTile(double X, double Y) const
+	{
+		return FIntPoint(FMath::FloorToInt(X / TileSize), FMath::FloorToInt(Y / TileSize));
+	}
+
+	FBox2D GetTileBounds(const FIntPoint& Tile) const
+	{
+		const FVector2D Min(Tile.X * (double)TileSize, Tile.Y * (double)TileSize);
+		return FBox2D(Min, Min + FVector2D(TileSize, TileSize));
+	}
+
+	bool Read(const FString& TileDirectory);
+
+	/**
+	 * Splits Records into tiles of TileSize and writes them to TileDirectory (replacing its previous contents) followed by the manifest.
+	 * Each tile is a regular .lmkb cooked with the given spatial index parameters.
+	 */
+	static bool Cook(const FString& TileDirectory, const TArray<FLandmarkInstanceData>& Records, float InTileSize, float SpatialBaseCellSize, float SpatialBaseAltitude);
+};
+
+/** Records of one tile, read on a worker. */
+struct FLandmarkTileLoad
+{
+	FIntPoint Tile = FIntPoint::ZeroValue;
+	TArray<FLandmarkInstanceData> Records;
+	TArray<FLandmarkId> Keys;
+	bool bSuccess = false;
+};
+
+/**
+ * FLandmarkTileStreamer
+ *
+ * 决定哪些瓦片常驻，并在工作线程上读取它们；注册与注销由子系统在游戏线程上完成。
+ * - 与视野足迹相交的瓦片必须常驻（不受预算限制），其外 Radius 范围内的瓦片按距离由近到远加载，直到用完内存预算。
+ * - 已常驻的瓦片在离开范围一个瓦片边长之后才卸载，避免相机在边界附近来回时反复加载。
+ * - 从不阻塞：尚未读完的瓦片对查询来说就是空的。
+ */
+class LANDMARKSYSTEM_API FLandmarkTileStreamer
+{
+public:
+	static constexpr int32 MaxLoadsInFlight = 4;
+
+	void Open(FLandmarkTileManifest&& InManifest);
+
+	/** Waits for loads in flight and forgets every tile. Landmarks registered from tiles are left to the caller. */
+	void Close();
+
+	bool IsOpen() const { return Manifest.TileSize > 0.0f; }
+	const FLandmarkTileManifest& GetManifest() const { return Manifest; }
+
+	/**
+	 * Picks the resident set for a view and starts loads for missing tiles, nearest first.
+	 * @param Required     Area that must be resident (the view footprint).
+	 * @param Focus        Point tiles are prioritized by distance from.
+	 * @param Radius       Residency margin around Required.
+	 * @param BudgetBytes  Cost limit for tiles outside Required; <= 0 is unlimited.
+	 * @param OutEvict     Receives the handles registered from tiles that should be unloaded now.
+	 */
+	void Update(const FBox2D& Required, const FVector2D& Focus, float Radius, int64 BudgetBytes, TArray<FLandmarkHandle>& OutEvict);
+
+	/** Moves finished loads of still-wanted tiles to OutLoaded; the caller registers them and reports back through SetResident. */
+	void CollectLoaded(TArray<TSharedPtr<FLandmarkTileLoad>>& OutLoaded);
+
+	void SetResident(const FIntPoint& Tile, TArray<FLandmarkHandle>&& Handles);
+
+	int32 NumResident() const { return NumResidentTiles; }
+	int32 NumLoading() const { return NumLoadingTiles; }
+
+	/** Cost of resident and loading tiles. */
+	int64 GetCommittedBytes() const { return CommittedBytes; }
+
+private:
+	struct FTileState
+	{
+		TArray<FLandmarkHandle> Handles;
+		TSharedPtr<FLandmarkTileLoad> Load;
+		UE::Tasks::FTask Task;
+		bool bResident = false;
+
+		/** A load whose tile left the wanted set is discarded when it completes. */
+		bool bWanted = true;
+	};
+
+	struct FCandidate
+	{
+		FIntPoint Tile;
+		double DistanceSq = 0.0;
+		int64 Bytes = 0;
+		bool bRequired = false;
+		bool bInRange = false;
+	};
+
+	void StartLoad(const FIntPoint& Tile, FTileState& State);
+	int64 GetTileBytes(const FIntPoint& Tile) const;
+
+	FLandmarkTileManifest Manifest;
+	TMap<FIntPoint, FTileState> States;
+	TArray<FCandidate> Candidates;
+	int64 CommittedBytes = 0;
+	int32 NumResidentTiles = 0;
+	int32 NumLoadingTiles = 0;
+};
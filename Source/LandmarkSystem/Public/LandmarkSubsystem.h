@@ -3,11 +3,219 @@
 #include "CoreMinimal.h"
 #include "Subsystems/WorldSubsystem.h"
 #include "LandmarkTypes.h"
+#include "LandmarkStore.h"
+#include "LandmarkSpatialIndex.h"
+#include "LandmarkBudget.h"
+#include "LandmarkFileFormat.h"
+#include "LandmarkJournal.h"
+#include "LandmarkStreaming.h"
 #include "MassAPIStructs.h"
+#include "Tasks/Task.h"
+#include "Containers/Ticker.h"
+#include <atomic>
 #include "LandmarkSubsystem.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogLandmarkSystem, Log, All);
 
+class UCanvas;
+class UFont;
+struct FFileChangeData;
+
+/**
+ * 一次剔除的结果（四个数组按下标一一对应）。
+ * 子系统持有两份：工作线程写后台缓冲，完成后原子切换前台索引，读者始终拿到完整的一帧。
+ */
+struct FLandmarkVisibleSet
+{
+	TArray<FLandmarkHandle> Handles;
+	TArray<FVector2D> ScreenPositions;
+	TArray<float> Scales;
+	/** 均不低于剔除时的 MinAlpha：绘制端不再按透明度过滤 */
+	TArray<float> Alphas;
+	TArray<float> Distances;
+
+	/** Request serial of the cull that produced this set. */
+	uint32 Serial = 0;
+
+	int32 Num() const { return Handles.Num(); }
+
+	/** Keeps the allocations for the next cull. */
+	void Reset()
+	{
+		Handles.Reset();
+		ScreenPositions.Reset();
+		Scales.Reset();
+		Alphas.Reset();
+		Distances.Reset();
+	}
+};
+
+/**
+ * 每个地标的绘制记录：预构建的文本、按字体测得的尺寸、以及某个缩放档位下 VP/名称 的堆叠偏移。
+ * 以 (槽位, 代数) 为键；名称/分值（存储修订号）、字体、语言或缩放档位变化时才重建，
+ * 稳态下绘制循环不做字符串格式化，也不测量文本。
+ */
+struct FLandmarkDrawRecord
+{
+	// --- 有效性键 ---
+	int32 Generation = 0;
+	uint32 Revision = 0;
+	uint32 CultureRevision = 0;
+	const UFont* NameFont = nullptr;
+	const UFont* VPFont = nullptr;
+
+	// --- 文本与未缩放尺寸（文本或字体变化时重建） ---
+	FText NameText;
+	FText VPText;
+	FVector2f NameSize = FVector2f::ZeroVector;
+	FVector2f VPSize = FVector2f::ZeroVector;
+	bool bHasVP = false;
+
+	// --- 缩放档位下的布局（相对锚点，向上堆叠：[Roof] <- [VP] <- [Name]） ---
+	int32 ScaleBucket = INDEX_NONE;
+	float Scale = 1.0f;
+	FVector2f NameOffset = FVector2f::ZeroVector;
+	FVector2f VPOffset = FVector2f::ZeroVector;
+
+	/** Screen-space size of the whole stack at Scale. */
+	FVector2f StackSize = FVector2f::ZeroVector;
+
+	/** 隐藏胜利点行时（预算控制）名称单独贴在锚点上 */
+	FVector2f NameOnlyOffset = FVector2f::ZeroVector;
+	FVector2f NameOnlySize = FVector2f::ZeroVector;
+};
+
+/**
+ * 最近一次完成的剔除结果的只读视图（不拷贝）。
+ * 各数组按下标一一对应，按 优先级 -> 类型 -> 距离 排序。
+ * 视图在下一次 UpdateCameraState 之前有效（双缓冲：再下一次剔除才会覆写这份缓冲）。
+ */
+struct FLandmarkVisibleView
+{
+	TConstArrayView<FLandmarkHandle> Handles;
+	TConstArrayView<FVector2D> ScreenPositions;
+	TConstArrayView<float> Scales;
+	TConstArrayView<float> Alphas;
+
+	int32 Num() const { return Handles.Num(); }
+};
+
+/** DrawOrder 的全部输入；任一变化时重新去重叠 */
+struct FLandmarkDrawOrderKey
+{
+	uint32 Serial = 0;
+	const UFont* NameFont = nullptr;
+	const UFont* VPFont = nullptr;
+	float BaseScale = 0.0f;
+	FIntPoint CanvasSize = FIntPoint::ZeroValue;
+	int32 MaxLabels = 0;
+	int32 CellSize = 0;
+	int32 MinPriority = MIN_int32;
+	bool bDeclutter = false;
+	bool bShowVP = true;
+
+	bool operator==(const FLandmarkDrawOrderKey& Other) const
+	{
+		return Serial == Other.Serial && NameFont == Other.NameFont && VPFont == Other.VPFont && BaseScale == Other.BaseScale
+			&& CanvasSize == Other.CanvasSize && MaxLabels == Other.MaxLabels && CellSize == Other.CellSize
+			&& MinPriority == Other.MinPriority && bDeclutter == Other.bDeclutter && bShowVP == Other.bShowVP;
+	}
+	bool operator!=(const FLandmarkDrawOrderKey& Other) const { return !(*this == Other); }
+};
+
+/** 相机快照：剔除所需的全部输入，在游戏线程上采集 */
+struct FLandmarkCullRequest
+{
+	FVector CameraLocation = FVector::ZeroVector;
+	FRotator CameraRotation = FRotator::ZeroRotator;
+	float FOV = 90.0f;
+	float AspectRatio = 16.0f / 9.0f;
+	float UnifiedZ = 147.0f;
+	float MaxDistance = 20000.0f;
+
+	/** 按 优先级 -> 类型 -> 距离 排序结果，供屏幕空间去重叠使用 */
+	bool bSortByPriority = true;
+
+	/** > 0: unless bRefreshFar, candidates beyond this distance are culled only if they were visible in the previous result (budget controller). */
+	float FarDistance = 0.0f;
+	bool bRefreshFar = true;
+
+	uint32 Serial = 0;
+};
+
+/** 剔除进行中时排队的存储修改 */
+enum class ELandmarkMutation : uint8
+{
+	Register,
+	Update,
+	Unregister,
+	UnregisterAll,
+};
+
+struct FLandmarkPendingMutation
+{
+	ELandmarkMutation Type = ELandmarkMutation::Register;
+	FString ID;
+	FLandmarkInstanceData Data;
+};
+
+/** 地图数据加载进度，见 ULandmarkSubsystem::GetLandmarkLoadState */
+UENUM(BlueprintType)
+enum class ELandmarkLoadState : uint8
+{
+	/** 尚未开始（非游戏世界，或世界尚未 BeginPlay） */
+	Idle,
+	/** 工作线程正在读取/解析地图数据文件 */
+	Loading,
+	/** 地标已注册，等待 OnWorldBeginPlay 生成城市实体 */
+	Loaded,
+	/** 地标已注册（标签可见），城市实体正在分帧生成，见 GetCitySpawnProgress */
+	Spawning,
+	/** 地标已注册，城市实体已生成 */
+	Ready,
+	/** 没有可读的地图数据文件；城市生成流程照常结束 */
+	Failed,
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnLandmarksLoaded, bool, bSuccess);
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnLandmarkSaveComplete, const FString&, FileName, bool, bSuccess);
+
+/** 在工作线程上读出的文件内容，由游戏线程一次性注册 */
+struct FLandmarkLoadResult
+{
+	FString FileName;
+	TArray<FLandmarkInstanceData> Records;
+
+	/** 仅 .lmkb：烘焙时算好的键（与 Records 一一对应），以及保持打开以读取预构建空间索引的文件 */
+	TArray<FLandmarkId> Keys;
+	TUniquePtr<FLandmarkBinaryFile> CookedFile;
+
+	/** 按瓦片烘焙过的地图：只读清单，瓦片随相机按需加载（此时 Records 为空） */
+	TUniquePtr<FLandmarkTileManifest> TileManifest;
+
+	double ReadSeconds = 0.0;
+	bool bSuccess = false;
+};
+
+/**
+ * 一次异步保存。游戏线程只拷贝快照（记录数组，或存储中需要保存的字段），
+ * 转换、哈希比对与写盘都在工作线程上进行；同一文件的保存按提交顺序串行执行。
+ */
+struct FLandmarkSaveRequest
+{
+	FString FileName;
+	FString Path;
+
+	/** 二选一：调用方给出的记录，或存储快照（工作线程上再展开为记录） */
+	TArray<FLandmarkInstanceData> Records;
+	TUniquePtr<FLandmarkSaveSnapshot> StoreSnapshot;
+
+	TSharedPtr<FLandmarkJournaledFile> Journal;
+	FOnLandmarkSaveComplete OnComplete;
+	UE::Tasks::FTask Task;
+	bool bSuccess = false;
+};
+
 /**
  * ULandmarkSubsystem
  * 
@@ -27,8 +235,12 @@ public:
 	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
 
 	// --- Registration API ---
+	/**
+	 * 注册地标。ID 为空时按内容生成确定性 64 位键；ID 已存在时合并并返回已有句柄。
+	 * 异步剔除进行中时注册会排队到剔除完成后执行，此时返回未设置的句柄。
+	 */
 	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
-	void RegisterLandmark(const FLandmarkInstanceData& Data);
+	FLandmarkHandle RegisterLandmark(const FLandmarkInstanceData& Data);
 
 	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
 	void UpdateLandmark(const FString& ID, const FLandmarkInstanceData& NewData);
@@ -40,12 +252,83 @@ public:
 	void UnregisterAll();
 
 	// --- File I/O ---
+	/**
+	 * Loads Content/MapData/FileName, replacing all landmarks.
+	 * A cooked .lmkb next to a .json (see LandmarkFileFormat.h) is used instead when it is not older than the JSON.
+	 * An in-flight map data load is only cancelled once the file has been read; on failure the current landmarks are kept.
+	 */
 	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
 	bool LoadLandmarksFromFile(const FString& FileName);
 
+	/**
+	 * Re-reads Content/MapData/FileName and applies only the difference, by ID, to the landmarks last loaded from it.
+	 * Unchanged landmarks keep their handles and entities; a city entity is respawned only when its type, team or position changed.
+	 * In PIE the loaded map file is watched and reloaded this way on every save (bHotReloadMapData).
+	 */
+	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
+	bool ReloadLandmarksFromFile(const FString& FileName);
+
+	/**
+	 * Saves DataToSave (the full set) to Content/MapData/FileName.
+	 * Coordinates are engine coordinates, as LoadLandmarksFromFile registers them, so the file loads back unchanged.
+	 * Only the records changed since the file was last written are appended to FileName's .journal.
+	 */
 	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
 	bool SaveLandmarksToFile(const FString& FileName, const TArray<FLandmarkInstanceData>& DataToSave);
 
+	/**
+	 * Same as SaveLandmarksToFile, but only the copy of DataToSave happens on the calling thread.
+	 * Serialization and the write run on a worker; OnComplete fires on the game thread afterwards.
+	 * The file on disk is always either the previous or the new version, even if the process dies mid-save.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem", meta = (AutoCreateRefTerm = "OnComplete"))
+	void SaveLandmarksToFileAsync(const FString& FileName, const TArray<FLandmarkInstanceData>& DataToSave, const FOnLandmarkSaveComplete& OnComplete);
+
+	/** Asynchronously saves every registered landmark (e.g. for autosave). The game thread only copies the fields that are saved. */
+	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem", meta = (AutoCreateRefTerm = "OnComplete"))
+	void SaveRegisteredLandmarksAsync(const FString& FileName, const FOnLandmarkSaveComplete& OnComplete);
+
+	/** 是否还有异步保存未完成（完成回调尚未触发） */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	bool IsSaveInFlight() const { return PendingSaves.Num() > 0; }
+
+	/** 阻塞到所有异步保存写完，并触发它们的完成回调 */
+	void WaitForPendingSaves();
+
+	/** Folds FileName's .journal back into the file. */
+	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
+	bool CompactLandmarkFile(const FString& FileName);
+
+	// --- Map data loading ---
+	/**
+	 * 地图数据（Landmarks_<Map>[_ZH]）在世界创建时于后台读取，完成后在游戏线程注册；
+	 * 世界 BeginPlay 之后再生成城市实体，然后广播本事件。已完成后才绑定的监听者请先查询 IsLandmarkLoadComplete。
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "LandmarkSystem")
+	FOnLandmarksLoaded OnLandmarksLoaded;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	ELandmarkLoadState GetLandmarkLoadState() const { return LoadState; }
+
+	/** 地图数据已注册且城市实体已生成（或确认没有数据文件） */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	bool IsLandmarkLoadComplete() const { return LoadState == ELandmarkLoadState::Ready || LoadState == ELandmarkLoadState::Failed; }
+
+	/** 同步回退（测试、服务器）：阻塞到后台读取结束并立即注册；世界已 BeginPlay 时同时生成城市（分帧生成时再调用 FlushPendingCitySpawns） */
+	void WaitForLandmarkLoad();
+
+	/** 分帧生成中尚未生成的城市数 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	int32 GetNumPendingCitySpawns() const { return PendingCitySpawns.Num() - NextCitySpawn; }
+
+	/** 城市实体生成进度 [0, 1]；加载完成时为 1 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	float GetCitySpawnProgress() const;
+
+	/** 立即生成所有排队的城市实体（测试、服务器）；处于 Spawning 时随后完成加载并广播 OnLandmarksLoaded */
+	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
+	void FlushPendingCitySpawns();
+
 	// --- Runtime API ---
 	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
 	void UpdateCameraState(const FVector& CameraLocation, const FRotator& CameraRotation, float FOV, float ZoomFactor);
@@ -53,8 +336,51 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
 	void DrawLandmarks(class UCanvas* InCanvas);
 
+	/** 拷贝完整地标数据（冷路径）。输出数组的已有内存会被复用 */
 	void GetVisibleLandmarks(TArray<FLandmarkInstanceData>& OutVisibleLandmarks, TArray<FVector2D>& OutScreenPositions, TArray<float>& OutScales, TArray<float>& OutAlphas);
 
+	/** 零拷贝访问可见集；地标字段通过 FindLandmarkRecord / GetLandmarkStore 按句柄读取 */
+	FLandmarkVisibleView GetVisibleView();
+
+	/** 句柄对应的冷数据（名称、类型等），句柄失效时返回 nullptr。指针在下一次注册/注销前有效 */
+	const FLandmarkColdData* FindLandmarkRecord(FLandmarkHandle Handle) const;
+
+	/** Blueprint 版本：只填句柄与屏幕数据，复用调用方数组的内存，不构造 FLandmarkInstanceData */
+	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
+	void GetVisibleLandmarkHandles(TArray<FLandmarkHandle>& OutHandles, TArray<FVector2D>& OutScreenPositions, TArray<float>& OutScales, TArray<float>& OutAlphas);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	FString GetLandmarkName(FLandmarkHandle Handle) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	int32 GetLandmarkValue(FLandmarkHandle Handle) const;
+
+	/** 异步剔除是否仍在工作线程上运行 */
+	bool IsVisibilityUpdateInFlight() const;
+
+	/** 阻塞等待进行中的剔除完成，并应用期间排队的修改 */
+	void WaitForVisibilityUpdate();
+
+	// --- Handle API ---
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	FLandmarkHandle FindLandmarkHandle(const FString& ID) const;
+
+	/** 按 64 位键查找（键即 FLandmarkId::Value，Blueprint 中以 int64 表示） */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	FLandmarkHandle FindLandmarkHandleByKey(int64 Key) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	int64 GetLandmarkKey(FLandmarkHandle Handle) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	bool IsLandmarkHandleValid(FLandmarkHandle Handle) const;
+
+	/** 通过句柄取回完整地标数据（冷路径，会拷贝字符串） */
+	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
+	bool GetLandmarkData(FLandmarkHandle Handle, FLandmarkInstanceData& OutData) const;
+
+	const FLandmarkStore& GetLandmarkStore() const { return Landmarks; }
+
 	// --- Command Grid Mapping ---
 	UFUNCTION(BlueprintCallable, Category = "LandmarkSystem")
 	void RegisterTypeGrid(const FString& Type, class URTSCommandGridAsset* GridAsset);
@@ -66,6 +392,17 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
 	FString FindTypeByEntity(FEntityHandle Handle) const;
 
+	/** 实体 -> 地标，O(1)。实体已失效时返回空句柄 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	FLandmarkHandle FindLandmarkByEntity(FEntityHandle Handle) const;
+
+	/** 地标 -> 实体，O(1)。地标或实体已失效时返回空句柄 */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "LandmarkSystem")
+	FEntityHandle FindEntityByLandmark(FLandmarkHandle Handle) const;
+
+	/** 由 ULandmarkEntityObserver 在城市实体销毁时调用 */
+	void HandleLandmarkEntityRemoved(const FMassEntityHandle& Entity);
+
 	// --- Configuration ---
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LandmarkSystem")
 	FRuntimeFloatCurve ScaleCurve;
@@ -80,32 +417,235 @@ public:
 	TObjectPtr<UFont> VPFont;
 
 protected:
-	UPROPERTY()
-	TMap<FString, FLandmarkInstanceData> RegisteredLandmarks;
+	/** 所有已注册地标（SoA 存储，剔除只读热数组） */
+	FLandmarkStore Landmarks;
 
-	TArray<FString> VisibleLandmarkIDs;
-	TArray<FVector2D> CachedScreenPositions;
-	TArray<float> CachedScales;
-	TArray<float> CachedAlphas;
+	/** 双缓冲的剔除结果；FrontVisibleSet 指向最近一次完成的一份 */
+	FLandmarkVisibleSet VisibleSets[2];
+	std::atomic<int32> FrontVisibleSet { 0 };
+
+	const FLandmarkVisibleSet& GetFrontVisibleSet() const { return VisibleSets[FrontVisibleSet.load(std::memory_order_acquire)]; }
 
 	UPROPERTY()
 	TMap<FString, TObjectPtr<class URTSCommandGridAsset>> TypeGridAssets;
 
-	TMap<FIntPoint, TArray<FString>> SpatialGrid;
+	/** 多分辨率空间索引（格子 -> 槽位索引），随注册/注销增量维护 */
+	FLandmarkSpatialIndex SpatialIndex;
 
-	float SpatialCellSize = 10000.0f;
 	void RebuildSpatialGrid();
 
+	/** Reads Content/MapData/FileName (preferring a fresh .lmkb) into Out. Touches no subsystem state, so it runs on workers. */
+	static bool ReadLandmarkFile(const FString& FileName, FLandmarkLoadResult& Out);
+
+	/**
+	 * Registers a read result on the game thread. Cooked records go straight into an empty store together with
+	 * the prebuilt spatial index; otherwise every record goes through RegisterLandmark.
+	 */
+	void ApplyLoadResult(FLandmarkLoadResult& Result, bool bReplaceExisting);
+	void AddToSpatialGrid(int32 Index);
+	void RemoveFromSpatialGrid(int32 Index);
+
 private:
 	/** 批量生成所有城市类型的 Mass 实体，通过 ULandmarkSettings 读取配置 */
 	void BatchSpawnAllCities();
 
-	/** 按类型名批量生成一组城市实体，返回句柄数组 */
+	static FString GetMapDataName(const UWorld& World);
+
+	/** Landmarks_<Map>_ZH，失败则 Landmarks_<Map>；bStreamTiles 时优先使用其瓦片清单 */
+	static void ReadMapData(const FString& MapName, bool bStreamTiles, FLandmarkLoadResult& Out);
+
+	/** Reads the tile manifest cooked from Content/MapData/FileName, if it exists and is not older than the JSON. */
+	static bool ReadLandmarkTiles(const FString& FileName, FLandmarkLoadResult& Out);
+
+	void StartMapDataLoad(const FString& MapName);
+	bool TickMapDataLoad(float DeltaTime);
+	void FinishMapDataLoad();
+
+	/** 等待并丢弃进行中的后台读取，加载状态回到 Idle（显式加载、换图或世界销毁时） */
+	void CancelMapDataLoad();
+
+	/** 数据已注册且世界已 BeginPlay 时生成城市并广播完成 */
+	void TryCompleteMapDataLoad();
+
+	/** 进入 Ready/Failed 并广播 OnLandmarksLoaded */
+	void CompleteLandmarkLoad();
+
+	/**
+	 * 分帧生成队列：按到 CitySpawnFocus 的距离排好序的句柄，NextCitySpawn 之前的已处理。
+	 * 句柄在出队时校验，期间被注销或已绑定实体的地标直接跳过。
+	 */
+	TArray<FLandmarkHandle> PendingCitySpawns;
+	int32 NextCitySpawn = 0;
+	FVector2D CitySpawnFocus = FVector2D::ZeroVector;
+	FTSTicker::FDelegateHandle CitySpawnTickerHandle;
+
+	/** Appends Slots to the spawn queue, nearest to CitySpawnFocus first, and starts the ticker. */
+	void QueueCitySpawns(TArray<int32>& Slots);
+
+	/** Spawns queued cities until a budget runs out (MaxEntities / BudgetSeconds <= 0 is unlimited). */
+	void SpawnQueuedCities(int32 MaxEntities, double BudgetSeconds);
+	bool TickCitySpawns(float DeltaTime);
+	void ResetCitySpawnQueue();
+
+	/** 每个保存过的文件的增量保存状态（上次写入的记录哈希）。异步保存在工作线程上持有其引用 */
+	TMap<FString, TSharedPtr<FLandmarkJournaledFile>> SaveJournals;
+
+	/** 提交顺序的异步保存；完成回调也按此顺序触发 */
+	TArray<TSharedPtr<FLandmarkSaveRequest>> PendingSaves;
+	FTSTicker::FDelegateHandle SaveTickerHandle;
+
+	/** Journal for Path; waits for any async save of the same file so the caller can use it directly. */
+	FLandmarkJournaledFile& GetSaveJournal(const FString& Path);
+
+	void StartSave(TSharedRef<FLandmarkSaveRequest> Request);
+	bool TickPendingSaves(float DeltaTime);
+
+	/** Fires callbacks of completed saves at the front of PendingSaves (all of them when bWait). */
+	void CompletePendingSaves(bool bWait);
+
+	UE::Tasks::FTask LoadTask;
+	TSharedPtr<FLandmarkLoadResult> PendingLoad;
+	FTSTicker::FDelegateHandle LoadTickerHandle;
+	FString LoadingMapName;
+	ELandmarkLoadState LoadState = ELandmarkLoadState::Idle;
+	bool bMapDataLoaded = false;
+	bool bWorldBegunPlay = false;
+
+	/** 绑定地标与实体，并给实体挂上 FLandmarkFragment 以便观察者感知销毁 */
+	void BindCityEntity(int32 Index, const FMassEntityHandle& Entity, FMassEntityManager& EntityManager);
+
+	/** 把地标的分值与视觉偏移同步到已绑定实体的 FLandmarkFragment */
+	void UpdateCityFragment(int32 Index, FMassEntityManager& EntityManager);
+
+	/** 解绑并（延迟）销毁槽位绑定的城市实体 */
+	void DestroyCityEntity(int32 Index);
+
+	/** 为给定槽位生成城市实体：按 (类型, 阵营) 分组各生成一批，按分组时记录的槽位写回 */
+	void SpawnCityEntities(TConstArrayView<int32> Slots);
+
+	/** 最近一次整体加载（或重载）的地图文件，及其中地标的键；重载时据此找出被删除的地标 */
+	FString MapFileName;
+	TSet<FLandmarkId> MapFileKeys;
+
+#if WITH_EDITOR
+	/** PIE 中监视 Content/MapData，MapFileName 或其日志变化时增量重载 */
+	void WatchMapFile();
+	void StopWatchingMapFile();
+	void HandleMapDataChanged(const TArray<FFileChangeData>& Changes);
+	bool TickHotReload(float DeltaTime);
+
+	FString WatchedDirectory;
+	FDelegateHandle MapDataWatcherHandle;
+	FTSTicker::FDelegateHandle HotReloadTickerHandle;
+#endif
+
+	/** 实体句柄是否仍指向存活实体 */
+	bool IsEntityAlive(const FMassEntityHandle& Entity) const;
+
+	/**
+	 * 按类型名为每个坐标生成一个城市实体。返回数组与 Locations 等长、按下标一一对应，生成失败的位置是未设置的句柄；
+	 * 配置缺失时整组失败，返回空数组。
+	 */
 	TArray<FEntityHandle> BatchSpawnCityType(const FString& TypeName, const TArray<FVector>& Locations, int32 Team = 0);
 
 	FVector LastCameraLoc;
 	FRotator LastCameraRot;
+	float LastFOV = 0.0f;
 	float LastZoomFactor = 0.5f;
 
-	bool ProjectWorldLocationToScreen(const FVector& WorldLocation, FVector2D& OutScreenPosition) const;
+	/** 上一次相机更新的视锥地面投影及其覆盖的格子行（复用内存） */
+	FLandmarkGroundFootprint ViewFootprint;
+	TArray<FLandmarkCellSpan> FootprintSpans;
+	TArray<FLandmarkCellSpan> PreviousSpans;
+
+	/**
+	 * 增量可见集：足迹内每个格子中通过高度过滤的槽位。
+	 * 平移时只增删进入/离开足迹的格子；下列参数任一变化（缩放、旋转）或数据变动时整体重建。
+	 */
+	TMap<FIntPoint, TArray<int32>> ActiveCells;
+	int32 ActiveLevel = INDEX_NONE;
+	float ActiveFilterZ = 0.0f;
+	FRotator ActiveRotation = FRotator::ZeroRotator;
+	float ActiveFOV = 0.0f;
+	float ActiveAspectRatio = 0.0f;
+	bool bVisibleSetDirty = true;
+
+	TArray<int32> EligibleScratch;
+
+	void AddActiveCell(const FIntPoint& Cell, const FLandmarkSpatialCell& Members);
+
+	float GetViewportAspectRatio() const;
+
+	/**
+	 * 剔除主体：足迹 -> 候选格子 -> 投影 -> 曲线表，结果写入 Out。
+	 * 异步模式下在工作线程运行，只读存储与空间索引；期间所有修改都经 PendingMutations 排队。
+	 */
+	void CullVisibleSet(const FLandmarkCullRequest& Request, const FLandmarkVisibleSet& Previous, FLandmarkVisibleSet& Out);
+
+	/** 按槽位索引的绘制记录缓存 */
+	TArray<FLandmarkDrawRecord> DrawRecords;
+	uint32 CultureRevision = 0;
+	FDelegateHandle CultureChangedHandle;
+
+	void HandleCultureChanged() { ++CultureRevision; }
+
+	/** 返回槽位在给定字体与缩放下的有效绘制记录，必要时（仅此时）格式化与测量文本 */
+	const FLandmarkDrawRecord& GetDrawRecord(UCanvas* Canvas, int32 Index, const UFont* UseNameFont, const UFont* UseVPFont, float VisualScale);
+
+	/**
+	 * 去重叠：按剔除结果的顺序（优先级 -> 类型 -> 距离）依次把标签矩形写入粗粒度屏幕占用格，
+	 * 与已占用格相交的标签丢弃，最多保留 MaxLabels 个。结果是 DrawOrder（可见集下标）。
+	 * 同一份可见集、字体与基础缩放只计算一次。
+	 */
+	void DeclutterVisibleSet(UCanvas* Canvas, const FLandmarkVisibleSet& Visible, const FLandmarkDrawOrderKey& Key);
+
+	/** 排序剔除结果用的临时下标与缓冲（与后台缓冲交换数组，复用内存） */
+	TArray<int32> SortScratch;
+	FLandmarkVisibleSet SortBuffer;
+
+	TArray<int32> DrawOrder;
+	FLandmarkDrawOrderKey DrawOrderKey;
+	TBitArray<> OccupancyGrid;
+	uint32 CullSerial = 0;
+
+	/** 回收已完成的剔除任务，并应用排队的修改（游戏线程） */
+	void PollVisibilityUpdate();
+
+	UE::Tasks::FTask CullTask;
+
+	/** 瓦片流式加载：相机足迹周围的瓦片常驻，其余不在存储与空间索引中 */
+	FLandmarkTileStreamer TileStreamer;
+	FLandmarkGroundFootprint StreamingFootprint;
+	TArray<TSharedPtr<FLandmarkTileLoad>> LoadedTiles;
+	TArray<FLandmarkHandle> EvictedLandmarks;
+
+	/** 注册读完的瓦片、卸载范围外的瓦片并发起新的读取（游戏线程，剔除不在途时） */
+	void UpdateTileStreaming(const FVector& CameraLocation, const FRotator& CameraRotation, float FOV);
+
+	/** 标签帧预算：游戏线程耗时 + 工作线程剔除耗时（周期数，任务完成时计入） */
+	FLandmarkBudgetController LabelBudget;
+	std::atomic<uint64> CullCycles { 0 };
+	uint32 FarRefreshCounter = 0;
+	TArray<FLandmarkPendingMutation> PendingMutations;
+
+	/** 每次相机更新构建一次，批量投影所有候选点 */
+	FLandmarkViewProjection ViewProjection;
+
+	// 剔除临时缓冲（SoA，跨帧复用，不重新分配）
+	TArray<int32> CandidateSlots;
+	TArray<float> CandidateRelX;
+	TArray<float> CandidateRelY;
+
+	/** 远处标签降频时，上一次可见集中的槽位 */
+	TBitArray<> PreviousVisibleSlots;
+
+	/** 并行剔除的分块结果（按块序合并，复用内存） */
+	TArray<FLandmarkCullChunk> CullChunks;
+
+	/** 并行整体重建时每个足迹行的过滤结果 */
+	TArray<TArray<TPair<FIntPoint, TArray<int32>>>> RebuildRows;
+
+	/** ScaleCurve / AlphaCurve 的烘焙查找表 */
+	FLandmarkCurveTable ScaleTable;
+	FLandmarkCurveTable AlphaTable;
 };
@@ -23,6 +23,10 @@ struct LANDMARKSYSTEM_API FLandmarkFragment : public FMassFragment
     UPROPERTY()
     FString LandmarkID;
 
+    /** FLandmarkId::Value of the landmark this entity was spawned for */
+    UPROPERTY()
+    uint64 LandmarkKey = 0;
+
     UPROPERTY()
     int32 VictoryPoints = 0;
 
@@ -119,6 +123,10 @@ struct FLandmarkInstanceData
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     int32 Team = 0;
 
+    // Label priority (FLandmarkVisualConfig::Priority). Higher wins when labels overlap on screen.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    int32 Priority = 0;
+
     // Visual Offset for the label (e.g. to raise it above the city mesh)
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     FVector VisualOffset = FVector::ZeroVector;
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class APlayerController;
+struct FRichCurve;
+
+/** One row of grid cells [MinX, MaxX] at row Y. */
+struct FLandmarkCellSpan
+{
+	int32 Y = 0;
+	int32 MinX = 0;
+	int32 MaxX = -1;
+
+	int32 Num() const { return FMath::Max(0, MaxX - MinX + 1); }
+};
+
+/**
+ * Calls Func(const FIntPoint& Cell) for every cell covered by Spans but not by Exclude.
+ * Both span lists must be in ascending Y with consecutive rows (as produced by GetCellSpans).
+ * Cost is O(rows + reported cells): a camera pan touches only the border cells.
+ */
+LANDMARKSYSTEM_API void ForEachCellNotIn(TConstArrayView<FLandmarkCellSpan> Spans, TConstArrayView<FLandmarkCellSpan> Exclude, TFunctionRef<void(const FIntPoint&)> Func);
+
+/**
+ * FLandmarkGroundFootprint
+ *
+ * 相机视锥与标签平面 (Z = CityLabelZOffset) 的交集：一个凸多边形。
+ * - 使用真实 FOV 与视口宽高比，倾斜的 RTS 相机只覆盖前方的梯形区域，而不是以相机为中心的正方形。
+ * - 远处用 MaxDistance（水平距离）截断，看向地平线时也保持有界。
+ */
+struct LANDMARKSYSTEM_API FLandmarkGroundFootprint
+{
+	/** Convex polygon on the label plane. Empty when the frustum does not reach the plane. */
+	TArray<FVector2D, TInlineAllocator<12>> Polygon;
+
+	FBox2D Bounds = FBox2D(ForceInit);
+
+	/**
+	 * @param HorizontalFOV  Degrees, as passed to UpdateCameraState.
+	 * @param AspectRatio    Viewport width / height.
+	 * @param PlaneZ         World Z of the label plane.
+	 * @param MaxDistance    Horizontal clip distance from the camera.
+	 * @return false if the frustum does not intersect the plane.
+	 */
+	bool Build(const FVector& CameraLocation, const FRotator& CameraRotation, float HorizontalFOV, float AspectRatio, float PlaneZ, float MaxDistance);
+
+	bool IsEmpty() const { return Polygon.Num() < 3; }
+
+	/** Rows of cells of the given size that overlap the polygon, in ascending Y. */
+	void GetCellSpans(float CellSize, TArray<FLandmarkCellSpan>& OutSpans) const;
+};
+
+/** Per-point result bits of FLandmarkViewProjection::ProjectBatch. */
+namespace ELandmarkProjection
+{
+	enum : uint8
+	{
+		InFront = 1 << 0,
+		OnScreen = 1 << 1,
+		Visible = InFront | OnScreen,
+	};
+}
+
+/**
+ * FLandmarkViewProjection
+ *
+ * 每次相机更新只构建一次的视图投影矩阵。
+ * 矩阵去掉了相机平移（translated view-projection），候选点先减去 ViewOrigin 再以 float 计算，
+ * 大坐标地图上也不丢精度。结果与 APlayerController::ProjectWorldLocationToScreen(bPlayerViewportRelative = true) 一致。
+ */
+struct LANDMARKSYSTEM_API FLandmarkViewProjection
+{
+	FMatrix44f TranslatedViewProjection = FMatrix44f::Identity;
+	FVector ViewOrigin = FVector::ZeroVector;
+	FVector2f ViewSize = FVector2f::ZeroVector;
+
+	/** Uses the local player's projection data, exactly as the per-point engine path does. */
+	bool BuildFromPlayer(APlayerController* PC);
+
+	/** Fallback without a viewport: perspective from the camera parameters. */
+	bool BuildFromCamera(const FVector& Location, const FRotator& Rotation, float HorizontalFOV, const FIntPoint& ViewportSize);
+
+	/**
+	 * Projects Num points at (RelX[i], RelY[i], RelZ) relative to ViewOrigin, four lanes at a time.
+	 * @param ScreenMargin  Pixels outside the viewport that still count as on screen.
+	 */
+	void ProjectBatch(const float* RelX, const float* RelY, float RelZ, int32 Num, float ScreenMargin,
+		float* OutScreenX, float* OutScreenY, uint8* OutFlags) const;
+};
+
+/**
+ * FLandmarkCurveTable
+ *
+ * 把距离曲线（ScaleCurve / AlphaCurve）烘焙成定长查找表，逐标签求值变成一次批量线性插值。
+ * - 采样区间为曲线首尾关键帧的时间范围，区间外按端点值钳制（等同默认的 Constant 外插）。
+ * - 关键帧内容的哈希没变就不重新烘焙，曲线在运行时被修改也会自动生效。
+ */
+struct LANDMARKSYSTEM_API FLandmarkCurveTable
+{
+	static constexpr int32 NumSamples = 256;
+
+	/**
+	 * Re-bakes if the curve's keys changed since the last call.
+	 * A null or empty curve yields the constant DefaultValue.
+	 */
+	void Update(const FRichCurve* Curve, float DefaultValue);
+
+	/** Out[i] = curve(Distances[i]). Branch-free; Out may not alias Distances. */
+	void EvalBatch(const float* Distances, int32 Num, float* Out) const;
+
+private:
+	/** NumSamples + 1 entries so the upper neighbour of the last segment is always valid. */
+	TArray<float> Samples;
+	float MinDistance = 0.0f;
+	float InvStep = 0.0f;
+	uint32 SourceHash = 0;
+	bool bBaked = false;
+};
+
+/** Output of CullCandidateRange for one chunk of candidates. Chunks are merged in order, so results do not depend on the thread count. */
+struct FLandmarkCullChunk
+{
+	TArray<int32> Slots;
+	TArray<float> ScreenX;
+	TArray<float> ScreenY;
+	TArray<float> Scales;
+	TArray<float> Alphas;
+	TArray<float> Distances;
+
+	/** Scratch reused across updates. */
+	TArray<float> TempX;
+	TArray<float> TempY;
+	TArray<uint8> Flags;
+
+	int32 Num() const { return Slots.Num(); }
+};
+
+/** Read-only inputs shared by all chunks of one cull. */
+struct FLandmarkCullInput
+{
+	const FLandmarkViewProjection* Projection = nullptr;
+	const FLandmarkCurveTable* ScaleTable = nullptr;
+	const FLandmarkCurveTable* AlphaTable = nullptr;
+
+	/** Candidate slots and their positions relative to Projection->ViewOrigin. */
+	const int32* Slots = nullptr;
+	const float* RelX = nullptr;
+	const float* RelY = nullptr;
+	float RelZ = 0.0f;
+
+	float ScreenMargin = 0.0f;
+	float MinAlpha = 0.0f;
+};
+
+/**
+ * Projects candidates [Begin, End), drops those off screen or below MinAlpha, and evaluates scale/alpha.
+ * Touches only Out and the const inputs, so disjoint ranges can run on different threads.
+ */
+LANDMARKSYSTEM_API void CullCandidateRange(const FLandmarkCullInput& In, int32 Begin, int32 End, FLandmarkCullChunk& Out);
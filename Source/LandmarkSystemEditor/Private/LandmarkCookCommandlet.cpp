@@ -0,0 +1,79 @@
+#include "LandmarkCookCommandlet.h"
+#include "LandmarkFileFormat.h"
+#include "LandmarkJournal.h"
+#include "LandmarkStreaming.h"
+#include "LandmarkSettings.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLandmarkCook, Log, All);
+
+ULandmarkCookCommandlet::ULandmarkCookCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 ULandmarkCookCommandlet::Main(const FString& Params)
+{
+	FString Dir = FPaths::ProjectContentDir() / TEXT("MapData");
+	FParse::Value(*Params, TEXT("Dir="), Dir);
+
+	float CellSize = 4096.0f;
+	float Altitude = 10000.0f;
+	if (const ULandmarkSettings* Settings = ULandmarkSettings::Get())
+	{
+		CellSize = Settings->SpatialBaseCellSize;
+		Altitude = Settings->SpatialBaseAltitude;
+	}
+	FParse::Value(*Params, TEXT("CellSize="), CellSize);
+	FParse::Value(*Params, TEXT("Altitude="), Altitude);
+
+	// 大于 0 时另外切分成瓦片，供流式加载使用
+	float TileSize = 0.0f;
+	FParse::Value(*Params, TEXT("TileSize="), TileSize);
+
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Dir / TEXT("Landmarks_*.json")), true, false);
+	if (Files.Num() == 0)
+	{
+		UE_LOG(LogLandmarkCook, Warning, TEXT("No Landmarks_*.json found in %s"), *Dir);
+		return 0;
+	}
+
+	int32 NumFailed = 0;
+	for (const FString& File : Files)
+	{
+		const FString JsonPath = Dir / File;
+		const FString BinaryPath = FPaths::ChangeExtension(JsonPath, LandmarkFileFormat::BinaryExtension);
+
+		TArray<FLandmarkInstanceData> Records;
+		if (!FLandmarkJournaledFile::Load(JsonPath, Records, true))
+		{
+			UE_LOG(LogLandmarkCook, Error, TEXT("Failed to read %s"), *JsonPath);
+			++NumFailed;
+			continue;
+		}
+
+		if (!LandmarkFileFormat::WriteBinary(BinaryPath, Records, CellSize, Altitude))
+		{
+			++NumFailed;
+			continue;
+		}
+
+		if (TileSize > 0.0f)
+		{
+			const FString TileDirectory = FLandmarkTileManifest::GetTileDirectory(JsonPath);
+			if (!FLandmarkTileManifest::Cook(TileDirectory, Records, TileSize, CellSize, Altitude))
+			{
+				UE_LOG(LogLandmarkCook, Error, TEXT("Failed to write tiles to %s"), *TileDirectory);
+				++NumFailed;
+			}
+		}
+	}
+
+	UE_LOG(LogLandmarkCook, Display, TEXT("Cooked %d of %d landmark files (CellSize=%.0f, Altitude=%.0f, TileSize=%.0f)"), Files.Num() - NumFailed, Files.Num(), CellSize, Altitude, TileSize);
+	return NumFailed > 0 ? 1 : 0;
+}
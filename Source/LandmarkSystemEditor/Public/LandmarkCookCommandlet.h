@@ -0,0 +1,24 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LandmarkCookCommandlet.generated.h"
+
+/**
+ * Converts Content/MapData/Landmarks_*.json to the cooked .lmkb format (see LandmarkFileFormat.h).
+ * 每个 JSON 旁生成同名 .lmkb：记录按 Hilbert 曲线排序，空间索引按项目设置预先构建。
+ *
+ * UnrealEditor-Cmd.exe <Project>.uproject -run=LandmarkCook [-Dir=<folder>] [-CellSize=<cm>] [-Altitude=<cm>] [-TileSize=<cm>]
+ * CellSize / Altitude 默认取 ULandmarkSettings；与运行时设置不一致时加载会改为逐点重建索引。
+ * 指定 TileSize 时另外写出 <Json 名>_Tiles/ 瓦片目录，供 bStreamLandmarkTiles 流式加载（见 LandmarkStreaming.h）。
+ */
+UCLASS()
+class ULandmarkCookCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	ULandmarkCookCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};